@@ -18,8 +18,10 @@
 #define PATH_MAX FILENAME_MAX
 #define __func__ __FUNCTION__
 
-//TODO: Windows 10 have a working mmap() implementation, this should apply only for Windows Phone 8 and older windows.
+// Windows Phone has no working mmap() implementation, desktop and store apps map files through mman.h
+#if (WINAPI_FAMILY == WINAPI_FAMILY_PHONE_APP)
 #define NO_MMAP 1
+#endif
 
 #define strerror_r(errno,buf,len) strerror_s(buf,len,errno)
 
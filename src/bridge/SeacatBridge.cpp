@@ -9,6 +9,11 @@
 extern "C" {
 #include "all_windows.h"
 #include "seacatcc.h"
+#include <fcntl.h>
+#include <sys/stat.h>
+#ifndef NO_MMAP
+#include "mman.h"
+#endif
 }
 
 using namespace SeaCatCSharpBridge;
@@ -282,4 +287,149 @@ int SeacatBridge::characteristics_store(const Platform::Array<String^>^  capabil
 	int rc = seacatcc_characteristics_store(cStore);
 	delete[] cStore;
 	return rc;
-}
\ No newline at end of file
+}
+
+// ===================================== MAPPED FILE =====================================
+
+MappedFile::MappedFile() : fd(-1), addr(nullptr), length(0) {
+}
+
+MappedFile::~MappedFile() {
+	close();
+}
+
+int MappedFile::open(String^ path, int size) {
+	close();
+	if (size <= 0) return SEACATCC_RC_E_INVALID_ARGS;
+
+	auto pathStr = StringToUnmanaged(path);
+	fd = _open(pathStr->c_str(), _O_RDWR | _O_CREAT | _O_BINARY, _S_IREAD | _S_IWRITE);
+	delete pathStr;
+
+	if (fd < 0) {
+		seacatcc_log('E', "Cannot open mapped file: %d", errno);
+		return SEACATCC_RC_E_GENERIC;
+	}
+
+	// the file must cover the whole mapping
+	if (_filelength(fd) < size && _chsize(fd, size) != 0) {
+		seacatcc_log('E', "Cannot resize mapped file: %d", errno);
+		close();
+		return SEACATCC_RC_E_GENERIC;
+	}
+
+#ifndef NO_MMAP
+	void* mapped = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	if (mapped == MAP_FAILED) {
+		seacatcc_log('E', "Cannot map file: %d", errno);
+		close();
+		return SEACATCC_RC_E_GENERIC;
+	}
+	addr = (byte*)mapped;
+#endif
+
+	length = size;
+	return SEACATCC_RC_OK;
+}
+
+int MappedFile::read(int offset, Platform::WriteOnlyArray<byte>^ destination) {
+	if (length == 0) return SEACATCC_RC_E_GENERIC;
+	if (offset < 0 || offset + (int)destination->Length > length) return SEACATCC_RC_E_INVALID_ARGS;
+
+#ifdef NO_MMAP
+	// positioned read of just the requested range
+	if (_lseek(fd, offset, SEEK_SET) != offset || _read(fd, destination->Data, destination->Length) != (int)destination->Length) {
+		seacatcc_log('E', "Cannot read mapped file: %d", errno);
+		return SEACATCC_RC_E_GENERIC;
+	}
+#else
+	memcpy(destination->Data, addr + offset, destination->Length);
+#endif
+	return SEACATCC_RC_OK;
+}
+
+int MappedFile::write(int offset, const Platform::Array<byte>^ source) {
+	if (length == 0) return SEACATCC_RC_E_GENERIC;
+	if (offset < 0 || offset + (int)source->Length > length) return SEACATCC_RC_E_INVALID_ARGS;
+
+#ifdef NO_MMAP
+	// positioned write of just the given bytes, sync makes them durable
+	if (_lseek(fd, offset, SEEK_SET) != offset || _write(fd, source->Data, source->Length) != (int)source->Length) {
+		seacatcc_log('E', "Cannot write mapped file: %d", errno);
+		return SEACATCC_RC_E_GENERIC;
+	}
+#else
+	memcpy(addr + offset, source->Data, source->Length);
+#endif
+	return SEACATCC_RC_OK;
+}
+
+int MappedFile::sync() {
+	if (length == 0) return SEACATCC_RC_E_GENERIC;
+
+#ifdef NO_MMAP
+	if (_commit(fd) != 0) {
+		seacatcc_log('E', "Cannot sync mapped file: %d", errno);
+		return SEACATCC_RC_E_GENERIC;
+	}
+#else
+	if (msync(addr, length, MS_SYNC) != 0) {
+		seacatcc_log('E', "Cannot sync mapped file: %d", errno);
+		return SEACATCC_RC_E_GENERIC;
+	}
+#endif
+	return SEACATCC_RC_OK;
+}
+
+void MappedFile::close() {
+	if (length > 0) {
+		sync();
+#ifndef NO_MMAP
+		munmap(addr, length);
+#endif
+		addr = nullptr;
+	}
+
+	if (fd >= 0) {
+		_close(fd);
+		fd = -1;
+	}
+
+	length = 0;
+}
+
+int MappedFile::exists(String^ path) {
+	auto pathStr = StringToUnmanaged(path);
+	struct _stat info;
+	int rc = _stat(pathStr->c_str(), &info);
+	delete pathStr;
+	return rc == 0 ? SEACATCC_RC_OK : SEACATCC_RC_E_GENERIC;
+}
+
+int MappedFile::remove(String^ path) {
+	auto pathStr = StringToUnmanaged(path);
+	int rc = ::remove(pathStr->c_str());
+	int error = errno;
+	delete pathStr;
+
+	if (rc != 0 && error != ENOENT) {
+		seacatcc_log('E', "Cannot remove file: %d", error);
+		return SEACATCC_RC_E_GENERIC;
+	}
+	return SEACATCC_RC_OK;
+}
+
+int MappedFile::rename(String^ from, String^ to) {
+	auto fromStr = StringToUnmanaged(from);
+	auto toStr = StringToUnmanaged(to);
+	int rc = ::rename(fromStr->c_str(), toStr->c_str());
+	int error = errno;
+	delete fromStr;
+	delete toStr;
+
+	if (rc != 0) {
+		seacatcc_log('E', "Cannot rename file: %d", error);
+		return SEACATCC_RC_E_GENERIC;
+	}
+	return SEACATCC_RC_OK;
+}
@@ -15,6 +15,10 @@ namespace SeaCatCSharpBridge
 		property int position;
 		property int limit;
 		property int capacity;
+		// id of the frame in the client frame pool, -1 for frames not owned by the pool
+		property int frameId;
+		// generation of the frame, changes every time the frame is borrowed from the pool
+		property int generation;
 	};
 
 	/**
@@ -127,4 +131,64 @@ namespace SeaCatCSharpBridge
 		*/
 		int characteristics_store(const Platform::Array<String^>^  capabilities);
 	};
+
+	/**
+	* File mapped into memory, used by the client for small fixed-size indices
+	* Falls back to positioned reads and writes of the file where mmap is not available (NO_MMAP, Windows Phone)
+	*/
+	public ref class MappedFile sealed
+	{
+	public:
+		MappedFile();
+		virtual ~MappedFile();
+
+		/**
+		* Opens (or creates) the file and maps its first size bytes, the file is extended if needed
+		*/
+		int open(String^ path, int size);
+
+		/**
+		* Copies destination->Length bytes from given offset of the mapping
+		*/
+		int read(int offset, Platform::WriteOnlyArray<byte>^ destination);
+
+		/**
+		* Copies source into the mapping at given offset
+		*/
+		int write(int offset, const Platform::Array<byte>^ source);
+
+		/**
+		* ~ msync, flushes the mapping into the file
+		*/
+		int sync();
+
+		/**
+		* Flushes and unmaps the file
+		*/
+		void close();
+
+		/**
+		* Returns RC_OK if the file exists
+		*/
+		static int exists(String^ path);
+
+		/**
+		* ~ remove, a missing file is not an error
+		*/
+		static int remove(String^ path);
+
+		/**
+		* ~ rename, the target must not exist (Windows)
+		*/
+		static int rename(String^ from, String^ to);
+
+		property int size {
+			int get() { return length; }
+		}
+
+	private:
+		int fd;
+		byte* addr;
+		int length;
+	};
 }
\ No newline at end of file
@@ -0,0 +1,74 @@
+﻿using System;
+using System.Threading.Tasks;
+using SeaCatCSharpClient.Utils;
+
+namespace SeaCatCSharpClient.Core {
+
+    /// <summary>
+    /// Fatal error recovery worker ('f'), asks the core to recover (yield 'f') with an exponential backoff
+    /// The backoff starts over once the client gets ready
+    /// </summary>
+    public class FatalRecovery {
+        private static string TAG = "FatalRecovery";
+
+        public static TimeSpan MIN_DELAY = TimeSpan.FromSeconds(1);
+        public static TimeSpan MAX_DELAY = TimeSpan.FromMinutes(5);
+
+        private Reactor reactor;
+        private Random random = new Random();
+        private TimeSpan delay = MIN_DELAY;
+        // recovery is scheduled already
+        private bool pending = false;
+
+        public FatalRecovery(Reactor reactor) {
+            this.reactor = reactor;
+        }
+
+        /// <summary>
+        /// Number of recovery attempts since the client was ready the last time
+        /// </summary>
+        public int Attempts { get; private set; } = 0;
+
+        /// <summary>
+        /// Schedules the recovery, repeated requests before it runs are ignored
+        /// </summary>
+        public void Recover() {
+            TimeSpan wait;
+            lock (this) {
+                if (pending) return;
+                pending = true;
+                Attempts++;
+
+                // up to 10% jitter so that clients failed at the same time don't come back at the same time
+                wait = TimeSpan.FromMilliseconds(delay.TotalMilliseconds * (1.0 + random.NextDouble() * 0.1));
+                delay = TimeSpan.FromMilliseconds(Math.Min(delay.TotalMilliseconds * 2, MAX_DELAY.TotalMilliseconds));
+            }
+
+            Logger.Debug(TAG, $"Recovering from fatal state in {wait.TotalSeconds:F1}s (attempt {Attempts})");
+            RecoverAsync(wait);
+        }
+
+        /// <summary>
+        /// The client is ready, the next failure is recovered from quickly again
+        /// </summary>
+        public void Reset() {
+            lock (this) {
+                delay = MIN_DELAY;
+                Attempts = 0;
+            }
+        }
+
+        private async void RecoverAsync(TimeSpan wait) {
+            await Task.Delay(wait).ConfigureAwait(false);
+
+            lock (this) {
+                pending = false;
+            }
+
+            int rc = reactor.Bridge.yield((char)RC.SeacatYields.RECOVER_FATAL);
+            if (rc != RC.RC_OK) {
+                Logger.Error(TAG, $"Return code {rc} in seacatcc.yield('f')");
+            }
+        }
+    }
+}
@@ -0,0 +1,142 @@
+﻿using SeaCatCSharpClient.Utils;
+using System;
+using System.Collections.Generic;
+using System.Diagnostics;
+using System.Linq;
+using System.Text;
+using System.Threading.Tasks;
+
+namespace SeaCatCSharpClient.Core {
+
+    /// <summary>
+    /// Chain of pooled frames that behaves as one continuous write buffer
+    /// Once the current frame is full, a new one is borrowed from the pool and writing continues there,
+    /// so that encoders don't need to care about the capacity of a single frame
+    /// The frames of a chain must be sent back to back, see Reactor.EmitChain
+    /// </summary>
+    public class FrameChain {
+
+        private FramePool pool;
+        private string reason;
+        private List<ByteBuffer> frames = new List<ByteBuffer>(1);
+        // number of bytes written into all frames but the last one
+        private int completedLength = 0;
+
+        public FrameChain(FramePool pool, string reason) : this(pool, pool.Borrow(reason), reason) {
+        }
+
+        public FrameChain(FramePool pool, ByteBuffer head, string reason) {
+            this.pool = pool;
+            this.reason = reason;
+            frames.Add(head);
+        }
+
+        /// <summary>
+        /// First frame of the chain
+        /// </summary>
+        public ByteBuffer Head => frames[0];
+
+        /// <summary>
+        /// Number of frames in the chain
+        /// </summary>
+        public int Count => frames.Count;
+
+        /// <summary>
+        /// All frames of the chain, in the order they are to be sent
+        /// </summary>
+        public IReadOnlyList<ByteBuffer> Frames => frames;
+
+        /// <summary>
+        /// Total number of bytes written into the chain
+        /// </summary>
+        public int Position => completedLength + Tail.Position;
+
+        private ByteBuffer Tail => frames[frames.Count - 1];
+
+        public void PutByte(byte value) {
+            NextWritable().PutByte(value);
+        }
+
+        public void PutShort(short value) {
+            ByteBuffer tail = Tail;
+            if (tail.Remaining >= sizeof(short)) {
+                tail.PutShort(value);
+            } else {
+                PutByte((byte)(value >> 8));
+                PutByte((byte)value);
+            }
+        }
+
+        public void PutInt(int value) {
+            ByteBuffer tail = Tail;
+            if (tail.Remaining >= sizeof(int)) {
+                tail.PutInt(value);
+            } else {
+                for (int shift = 24; shift >= 0; shift -= 8) {
+                    PutByte((byte)(value >> shift));
+                }
+            }
+        }
+
+        public void PutBytes(byte[] values) {
+            PutBytes(values, 0, values.Length);
+        }
+
+        public void PutBytes(byte[] values, int offset, int count) {
+            while (count > 0) {
+                ByteBuffer frame = NextWritable();
+                int chunk = Math.Min(count, frame.Remaining);
+                frame.PutBytes(values, offset, chunk);
+                offset += chunk;
+                count -= chunk;
+            }
+        }
+
+        /// <summary>
+        /// Overwrites an integer at given absolute position of the chain (e.g. frame length placeholder)
+        /// </summary>
+        /// <param name="offset">position counted from the beginning of the head frame</param>
+        /// <param name="value">value to write</param>
+        public void PutInt(int offset, int value) {
+            Debug.Assert(offset + sizeof(int) <= Position);
+
+            if (offset + sizeof(int) <= Head.Position) {
+                Head.PutInt(offset, value);
+                return;
+            }
+
+            for (int i = 0; i < sizeof(int); i++) {
+                int index = offset + i;
+                int frameIdx = 0;
+                while (index >= frames[frameIdx].Position) {
+                    index -= frames[frameIdx].Position;
+                    frameIdx++;
+                }
+                frames[frameIdx].Data[index] = (byte)(value >> (24 - 8 * i));
+            }
+        }
+
+        /// <summary>
+        /// Gives all frames of the chain back to the pool, used when the chain won't be sent
+        /// </summary>
+        public void GiveBack() {
+            foreach (var frame in frames) {
+                pool.GiveBack(frame);
+            }
+            frames.Clear();
+        }
+
+        /// <summary>
+        /// Returns the last frame if there is a space in it, otherwise borrows a new one
+        /// </summary>
+        private ByteBuffer NextWritable() {
+            ByteBuffer tail = Tail;
+            if (tail.Remaining > 0) return tail;
+
+            completedLength += tail.Position;
+            tail = pool.Borrow(reason);
+            frames.Add(tail);
+            return tail;
+        }
+    }
+}
@@ -1,4 +1,5 @@
-﻿using SeaCatCSharpClient.Utils;
+﻿using SeaCatCSharpBridge;
+using SeaCatCSharpClient.Utils;
 using System;
 using System.Collections.Generic;
 using System.IO;
@@ -11,10 +12,18 @@ namespace SeaCatCSharpClient.Core {
     
     /// <summary>
     /// Pool where frames not actually used are stored for future need
+    /// Every frame created by the pool gets a stable pool id; together with a generation
+    /// that is incremented on each borrow it identifies the frame on its way through the bridge
     /// </summary>
     public class FramePool {
         private static string TAG = "FramePool";
         private Stack<ByteBuffer> stack = new Stack<ByteBuffer>();
+        // all frames created by this pool, indexed by their pool id
+        private List<ByteBuffer> frames = new List<ByteBuffer>();
+        // wrappers passed to the bridge, indexed by pool id of the frame they wrap
+        private List<ByteBuffWrapper> wrappers = new List<ByteBuffWrapper>();
+        // pool ids of discarded frames that can be reused
+        private Stack<int> freeIds = new Stack<int>();
         private int lowWaterMark;
         private int highWaterMark;
         private int frameCapacity;
@@ -25,6 +34,9 @@ namespace SeaCatCSharpClient.Core {
 
         protected double before = 0;
         private int totalCount = 0;
+        private int doubleReturnCount = 0;
+        private int foreignReturnCount = 0;
+        private int staleReturnCount = 0;
 
         public FramePool() {
             this.lowWaterMark = DEFAULT_LOW_WATER_MARK;
@@ -37,6 +49,21 @@ namespace SeaCatCSharpClient.Core {
             this.highWaterMark = highWaterMark;
             this.frameCapacity = frameCapacity;
         }
+
+        /// <summary>
+        /// Number of frames that were given back while not being borrowed
+        /// </summary>
+        public int DoubleReturnCount => doubleReturnCount;
+
+        /// <summary>
+        /// Number of frames given back that don't belong to this pool
+        /// </summary>
+        public int ForeignReturnCount => foreignReturnCount;
+
+        /// <summary>
+        /// Number of frame handles given back with an outdated generation
+        /// </summary>
+        public int StaleReturnCount => staleReturnCount;
         
         /// <summary>
         /// Borrows a frame for specific reason
@@ -46,34 +73,56 @@ namespace SeaCatCSharpClient.Core {
         /// <returns></returns>
         public ByteBuffer Borrow(String reason) {
             Logger.Debug(TAG, $"Borrowing frame; reason: {reason}");
-            ByteBuffer frame;
+            ByteBuffer frame = null;
 
-            try {
-                lock (stack) {
-                    frame = stack.Pop();
-                }
-            } catch (InvalidOperationException) {
+            lock (stack) {
+                if (stack.Count > 0) frame = stack.Pop();
+            }
+
+            if (frame == null) {
                 if (totalCount >= highWaterMark) throw new IOException("No more available frames in the pool.");
                 frame = CreateByteBuffer();
             }
 
+            lock (frames) {
+                frame.Generation++;
+                frame.Borrowed = true;
+            }
+
             return frame;
         }
 
         /// <summary>
         /// Gives back a borrowed frame
+        /// Frames that don't belong to the pool or that are not borrowed are counted and ignored
         /// </summary>
         /// <param name="frame"></param>
         public void GiveBack(ByteBuffer frame) {
             Logger.Debug(TAG, $"Giving back frame of length: {frame.Length}");
 
+            lock (frames) {
+                if (!IsOwned(frame)) {
+                    Interlocked.Increment(ref foreignReturnCount);
+                    Logger.Error(TAG, "Frame that doesn't belong to the pool given back");
+                    return;
+                }
+
+                if (!frame.Borrowed) {
+                    Interlocked.Increment(ref doubleReturnCount);
+                    Logger.Error(TAG, $"Frame {frame.PoolId} given back more than once");
+                    return;
+                }
+
+                frame.Borrowed = false;
+            }
+
+            frame.Reset();
+
             if (totalCount > lowWaterMark) {
                 // Discard the frame since the pool has enough frames available
-                frame.Reset();
-                Interlocked.Decrement(ref totalCount);
+                Discard(frame);
             } else {
                 // Store the frame back to the pool
-                frame.Reset();
                 lock (stack) {
                     stack.Push(frame);
                     Logger.Debug(TAG, $"Frames on the stack: {stack.Count}");
@@ -81,8 +130,61 @@ namespace SeaCatCSharpClient.Core {
             }
         }
 
+        /// <summary>
+        /// Gives back a borrowed frame identified by its pool id and generation
+        /// </summary>
+        /// <param name="frameId">pool id of the frame</param>
+        /// <param name="generation">generation the frame has been borrowed with</param>
+        public void GiveBack(int frameId, int generation) {
+            ByteBuffer frame = Lookup(frameId, generation);
+            if (frame == null) {
+                Interlocked.Increment(ref staleReturnCount);
+                Logger.Error(TAG, $"Unknown frame {frameId}:{generation} given back");
+                return;
+            }
+
+            GiveBack(frame);
+        }
+
+        /// <summary>
+        /// Finds a borrowed frame by its pool id and generation
+        /// </summary>
+        /// <returns>borrowed frame or null if the handle is unknown or stale</returns>
+        public ByteBuffer Lookup(int frameId, int generation) {
+            lock (frames) {
+                if (frameId < 0 || frameId >= frames.Count) return null;
+                ByteBuffer frame = frames[frameId];
+                if (frame == null || !frame.Borrowed || frame.Generation != generation) return null;
+                return frame;
+            }
+        }
+
+        /// <summary>
+        /// Returns the wrapper of given frame to be passed to the bridge
+        /// The wrapper is created once per pooled frame and reused afterwards
+        /// </summary>
+        public ByteBuffWrapper Wrap(ByteBuffer frame) {
+            ByteBuffWrapper wrapper;
+
+            lock (frames) {
+                if (IsOwned(frame)) {
+                    wrapper = wrappers[frame.PoolId];
+                } else {
+                    wrapper = new ByteBuffWrapper();
+                    wrapper.data = frame.Data;
+                    wrapper.frameId = -1;
+                }
+                wrapper.generation = frame.Generation;
+            }
+
+            wrapper.capacity = frame.Capacity;
+            wrapper.limit = frame.Limit;
+            wrapper.position = frame.Position;
+            return wrapper;
+        }
+
         public int Size() {
-            lock (this) {
+            lock (stack) {
                 return stack.Count();
             }
         }
@@ -93,15 +195,43 @@ namespace SeaCatCSharpClient.Core {
             // nothing to do here for now
         }
 
+        private bool IsOwned(ByteBuffer frame) {
+            return frame.PoolId >= 0 && frame.PoolId < frames.Count && frames[frame.PoolId] == frame;
+        }
+
         private ByteBuffer CreateByteBuffer() {
-            lock (this) {
+            lock (frames) {
                 Interlocked.Increment(ref totalCount);
                 Logger.Debug(TAG, $"Creating byte buffer; total count: {totalCount}");
                 ByteBuffer frame = new ByteBuffer(frameCapacity);
+
+                ByteBuffWrapper wrapper = new ByteBuffWrapper();
+                wrapper.data = frame.Data;
+
+                if (freeIds.Count > 0) {
+                    frame.PoolId = freeIds.Pop();
+                    frames[frame.PoolId] = frame;
+                    wrappers[frame.PoolId] = wrapper;
+                } else {
+                    frame.PoolId = frames.Count;
+                    frames.Add(frame);
+                    wrappers.Add(wrapper);
+                }
+
+                wrapper.frameId = frame.PoolId;
                 return frame;
             }
         }
 
+        private void Discard(ByteBuffer frame) {
+            lock (frames) {
+                frames[frame.PoolId] = null;
+                wrappers[frame.PoolId] = null;
+                freeIds.Push(frame.PoolId);
+                Interlocked.Decrement(ref totalCount);
+            }
+        }
+
     }
 
 }
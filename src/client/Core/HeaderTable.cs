@@ -0,0 +1,174 @@
+﻿using System;
+using System.Collections.Generic;
+using System.Linq;
+using System.Text;
+using System.Threading.Tasks;
+
+namespace SeaCatCSharpClient.Core {
+
+    /// <summary>
+    /// HPACK-like header table used by ALX1 header compression extension
+    /// It consists of a static part shared with the gateway and a dynamic part that is filled by the header blocks
+    /// The encoder and the decoder keep their own instance, both are valid for one gateway connection only
+    /// Indices are 1-based, static entries go first, dynamic entries follow with the newest one first
+    /// </summary>
+    public class HeaderTable {
+
+        public static int DEFAULT_MAX_SIZE = 4096;
+
+        // overhead of a single entry as defined by HPACK
+        private static int ENTRY_OVERHEAD = 32;
+
+        private static KeyValuePair<string, string>[] STATIC_TABLE = {
+            Entry(":host", ""),
+            Entry(":method", "GET"),
+            Entry(":method", "POST"),
+            Entry(":method", "PUT"),
+            Entry(":method", "DELETE"),
+            Entry(":path", "/"),
+            Entry("accept", ""),
+            Entry("accept", "*/*"),
+            Entry("accept", "application/json"),
+            Entry("accept-charset", ""),
+            Entry("accept-encoding", ""),
+            Entry("accept-encoding", "gzip, deflate"),
+            Entry("accept-language", ""),
+            Entry("accept-ranges", ""),
+            Entry("accept-ranges", "bytes"),
+            Entry("age", ""),
+            Entry("allow", ""),
+            Entry("authorization", ""),
+            Entry("cache-control", ""),
+            Entry("cache-control", "no-cache"),
+            Entry("content-disposition", ""),
+            Entry("content-encoding", ""),
+            Entry("content-encoding", "gzip"),
+            Entry("content-language", ""),
+            Entry("content-length", ""),
+            Entry("content-length", "0"),
+            Entry("content-location", ""),
+            Entry("content-range", ""),
+            Entry("content-type", ""),
+            Entry("content-type", "application/json"),
+            Entry("content-type", "application/json; charset=utf-8"),
+            Entry("content-type", "text/html; charset=utf-8"),
+            Entry("content-type", "text/plain; charset=utf-8"),
+            Entry("cookie", ""),
+            Entry("date", ""),
+            Entry("etag", ""),
+            Entry("expect", ""),
+            Entry("expires", ""),
+            Entry("if-match", ""),
+            Entry("if-modified-since", ""),
+            Entry("if-none-match", ""),
+            Entry("if-range", ""),
+            Entry("if-unmodified-since", ""),
+            Entry("last-modified", ""),
+            Entry("link", ""),
+            Entry("location", ""),
+            Entry("range", ""),
+            Entry("referer", ""),
+            Entry("retry-after", ""),
+            Entry("server", ""),
+            Entry("set-cookie", ""),
+            Entry("transfer-encoding", ""),
+            Entry("user-agent", ""),
+            Entry("vary", ""),
+            Entry("vary", "accept-encoding"),
+            Entry("via", ""),
+            Entry("www-authenticate", ""),
+        };
+
+        private List<KeyValuePair<string, string>> dynamicTable = new List<KeyValuePair<string, string>>();
+        private int size = 0;
+        private int maxSize;
+
+        public HeaderTable() : this(DEFAULT_MAX_SIZE) {
+        }
+
+        public HeaderTable(int maxSize) {
+            this.maxSize = maxSize;
+        }
+
+        public static int StaticCount => STATIC_TABLE.Length;
+
+        /// <summary>
+        /// Number of all entries, static and dynamic
+        /// </summary>
+        public int Count => STATIC_TABLE.Length + dynamicTable.Count;
+
+        /// <summary>
+        /// Current size of the dynamic table (in HPACK units)
+        /// </summary>
+        public int Size => size;
+
+        /// <summary>
+        /// Returns entry at given 1-based index
+        /// </summary>
+        public KeyValuePair<string, string> Get(int index) {
+            if (index < 1 || index > Count) throw new ArgumentOutOfRangeException($"Invalid header table index {index}");
+            if (index <= STATIC_TABLE.Length) return STATIC_TABLE[index - 1];
+            return dynamicTable[index - STATIC_TABLE.Length - 1];
+        }
+
+        /// <summary>
+        /// Finds the best matching entry
+        /// </summary>
+        /// <param name="name">lower-case header name</param>
+        /// <param name="value">header value</param>
+        /// <param name="nameIndex">index of the first entry with the same name, 0 if there is none</param>
+        /// <returns>index of the entry with both name and value matching, 0 if there is none</returns>
+        public int Find(string name, string value, out int nameIndex) {
+            nameIndex = 0;
+
+            for (int i = 0; i < STATIC_TABLE.Length; i++) {
+                if (!string.Equals(STATIC_TABLE[i].Key, name, StringComparison.Ordinal)) continue;
+                if (nameIndex == 0) nameIndex = i + 1;
+                if (string.Equals(STATIC_TABLE[i].Value, value, StringComparison.Ordinal)) return i + 1;
+            }
+
+            for (int i = 0; i < dynamicTable.Count; i++) {
+                if (!string.Equals(dynamicTable[i].Key, name, StringComparison.Ordinal)) continue;
+                if (nameIndex == 0) nameIndex = STATIC_TABLE.Length + i + 1;
+                if (string.Equals(dynamicTable[i].Value, value, StringComparison.Ordinal)) return STATIC_TABLE.Length + i + 1;
+            }
+
+            return 0;
+        }
+
+        /// <summary>
+        /// Inserts a new entry into the dynamic table, evicting the oldest entries when necessary
+        /// </summary>
+        public void Add(string name, string value) {
+            int entrySize = EntrySize(name, value);
+
+            while (size + entrySize > maxSize && dynamicTable.Count > 0) {
+                var evicted = dynamicTable[dynamicTable.Count - 1];
+                dynamicTable.RemoveAt(dynamicTable.Count - 1);
+                size -= EntrySize(evicted.Key, evicted.Value);
+            }
+
+            // entries larger than the whole table just empty it
+            if (entrySize > maxSize) return;
+
+            dynamicTable.Insert(0, Entry(name, value));
+            size += entrySize;
+        }
+
+        /// <summary>
+        /// Empties the dynamic table, used when the gateway connection is reset
+        /// </summary>
+        public void Clear() {
+            dynamicTable.Clear();
+            size = 0;
+        }
+
+        private static int EntrySize(string name, string value) {
+            return Encoding.UTF8.GetByteCount(name) + Encoding.UTF8.GetByteCount(value) + ENTRY_OVERHEAD;
+        }
+
+        private static KeyValuePair<string, string> Entry(string name, string value) {
+            return new KeyValuePair<string, string>(name, value);
+        }
+    }
+}
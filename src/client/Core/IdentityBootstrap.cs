@@ -0,0 +1,167 @@
+﻿using System;
+using System.IO;
+using System.Threading.Tasks;
+using SeaCatCSharpClient.Utils;
+
+namespace SeaCatCSharpClient.Core {
+
+    /// <summary>
+    /// Phases of obtaining the client identity, in the order they are reached
+    /// </summary>
+    public enum IdentityPhase {
+        NotStarted,
+        GeneratingKey,
+        KeyReady,
+        CsrSubmitted,
+        SignedIn
+    }
+
+    /// <summary>
+    /// Drives the identity bootstrap: private key generation (PPK worker), CSR and signing in to the gateway
+    /// Key generation may be started before the core asks for it and the CSR may be prepared in advance,
+    /// so that it is submitted as soon as the core requests it
+    /// </summary>
+    public class IdentityBootstrap {
+        private static string TAG = "IdentityBootstrap";
+
+        private Reactor reactor;
+        private IdentityPhase phase = IdentityPhase.NotStarted;
+        // PPK worker is running
+        private bool generating = false;
+        // CSR prepared by the app, null for the default one
+        private CSR csr = null;
+        private IProgress<IdentityPhase> progress = null;
+        private double startedAt = double.NaN;
+        private TaskCompletionSource<bool> keyReady = new TaskCompletionSource<bool>();
+        private TaskCompletionSource<bool> signedIn = new TaskCompletionSource<bool>();
+
+        public IdentityBootstrap(Reactor reactor) {
+            this.reactor = reactor;
+        }
+
+        public IdentityPhase Phase {
+            get {
+                lock (this) {
+                    return phase;
+                }
+            }
+        }
+
+        /// <summary>
+        /// Completed once the private key is available
+        /// </summary>
+        public Task KeyReady => keyReady.Task;
+
+        /// <summary>
+        /// Completed once the client is signed in to the gateway
+        /// </summary>
+        public Task SignedIn => signedIn.Task;
+
+        /// <summary>
+        /// Time from the initialization to the first signed-in state in seconds, NaN if not signed in yet
+        /// </summary>
+        public double TimeToSignedIn { get; private set; } = double.NaN;
+
+        /// <summary>
+        /// Starts key generation in the background unless the key exists or is being generated already
+        /// </summary>
+        /// <param name="csr">CSR to submit as soon as the core asks for it, null for the default one</param>
+        /// <param name="progress">reports each phase reached from now on</param>
+        public void Pregenerate(CSR csr, IProgress<IdentityPhase> progress) {
+            bool generate;
+            lock (this) {
+                if (csr != null) this.csr = csr;
+                if (progress != null) this.progress = progress;
+                generate = phase < IdentityPhase.KeyReady;
+            }
+
+            Logger.Debug(TAG, $"Identity requested in phase {phase}");
+            if (generate) GenerateKey();
+        }
+
+        /// <summary>
+        /// PPK worker ('P'), runs at most once at a time whoever asks for it first
+        /// </summary>
+        public void GenerateKey() {
+            lock (this) {
+                if (generating) return;
+                generating = true;
+            }
+
+            Advance(IdentityPhase.GeneratingKey);
+            TaskHelper.CreateTask("PPkGen worker", () => {
+                try {
+                    reactor.Bridge.ppkgen_worker();
+                } finally {
+                    lock (this) {
+                        generating = false;
+                    }
+                }
+            }).Start();
+        }
+
+        /// <summary>
+        /// CSR worker ('C'), submits the prepared CSR at once
+        /// </summary>
+        public void SubmitCsr() {
+            CSR prepared;
+            lock (this) {
+                prepared = csr;
+            }
+
+            Advance(IdentityPhase.CsrSubmitted);
+            if (prepared == null) {
+                CSR.CreateDefault()?.Start();
+                return;
+            }
+
+            TaskHelper.CreateTask("CSR", () => {
+                try {
+                    prepared.Submit();
+                } catch (IOException e) {
+                    Logger.Error(TAG, $"Cannot submit CSR: {e.Message}");
+                }
+            }).Start();
+        }
+
+        /// <summary>
+        /// Follows the core state: PPK and signed-in flags mark the phases reached
+        /// </summary>
+        public void StateChanged(string state) {
+            lock (this) {
+                if (double.IsNaN(startedAt)) startedAt = reactor.Bridge.time();
+            }
+
+            if (state[3] == (char)RC.SeacatState.PPK_READY) Advance(IdentityPhase.KeyReady);
+            if (state[4] == (char)RC.SeacatState.GWCONN_SIGNED_IN) Advance(IdentityPhase.SignedIn);
+        }
+
+        /// <summary>
+        /// Moves to given phase unless it has been passed already, reports the progress
+        /// </summary>
+        private void Advance(IdentityPhase next) {
+            IProgress<IdentityPhase> reportTo;
+            lock (this) {
+                if (next <= phase) return;
+                phase = next;
+                reportTo = progress;
+
+                if (next == IdentityPhase.SignedIn && double.IsNaN(TimeToSignedIn)) {
+                    TimeToSignedIn = reactor.Bridge.time() - startedAt;
+                }
+            }
+
+            Logger.Debug(TAG, $"Identity phase {next}");
+            if (next >= IdentityPhase.KeyReady) keyReady.TrySetResult(true);
+            if (next == IdentityPhase.SignedIn) {
+                Logger.Debug(TAG, $"Signed in {TimeToSignedIn:F2}s after initialization");
+                signedIn.TrySetResult(true);
+            }
+
+            reportTo?.Report(next);
+            var evt = new EventMessage(SeaCatClient.ACTION_SEACAT_IDENTITY_PROGRESS);
+            evt.PutExtra(SeaCatClient.EXTRA_IDENTITY_PHASE, next.ToString());
+            EventDispatcher.Dispatcher.SendBroadcast(evt);
+        }
+    }
+}
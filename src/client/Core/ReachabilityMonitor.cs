@@ -0,0 +1,88 @@
+﻿using System;
+using Windows.Networking.Connectivity;
+using SeaCatCSharpClient.Utils;
+
+namespace SeaCatCSharpClient.Core {
+
+    /// <summary>
+    /// Watches network changes reported by the OS and tells the core at once that the network is reachable again ('Q'),
+    /// so that a reconnect after e.g. Wi-Fi to cellular switch doesn't wait for the core's retry interval
+    /// </summary>
+    public class ReachabilityMonitor {
+        private static string TAG = "ReachabilityMonitor";
+
+        private Reactor reactor;
+        private bool started = false;
+        // the core asked for the network not-reachable worker ('n') and waits for 'Q'
+        private bool unreachable = false;
+
+        public ReachabilityMonitor(Reactor reactor) {
+            this.reactor = reactor;
+        }
+
+        /// <summary>
+        /// True if there is a network connection the gateway may be reached through
+        /// </summary>
+        public static bool IsNetworkReachable {
+            get {
+                var profile = NetworkInformation.GetInternetConnectionProfile();
+                return profile != null && profile.GetNetworkConnectivityLevel() != NetworkConnectivityLevel.None;
+            }
+        }
+
+        public void Start() {
+            lock (this) {
+                if (started) return;
+                started = true;
+            }
+            NetworkInformation.NetworkStatusChanged += NetworkStatusChanged;
+        }
+
+        public void Stop() {
+            lock (this) {
+                if (!started) return;
+                started = false;
+            }
+            NetworkInformation.NetworkStatusChanged -= NetworkStatusChanged;
+        }
+
+        /// <summary>
+        /// Network not-reachable worker ('n'); yields 'Q' right away if the OS already has a connection,
+        /// otherwise once it reports one
+        /// </summary>
+        public void NetworkUnreachable() {
+            lock (this) {
+                unreachable = true;
+            }
+
+            if (IsNetworkReachable) {
+                Yield("network is reachable already");
+            } else {
+                Logger.Debug(TAG, "Waiting for network");
+            }
+        }
+
+        private void NetworkStatusChanged(object sender) {
+            if (!IsNetworkReachable) {
+                Logger.Debug(TAG, "Network lost");
+                return;
+            }
+
+            Yield("network changed");
+        }
+
+        private void Yield(string reason) {
+            bool wasUnreachable;
+            lock (this) {
+                wasUnreachable = unreachable;
+                unreachable = false;
+            }
+
+            Logger.Debug(TAG, $"Network reachable ({reason}), core waited: {wasUnreachable}");
+            int rc = reactor.Bridge.yield((char)RC.SeacatYields.NETWORK_REACHABLE);
+            if (rc != RC.RC_OK) {
+                Logger.Error(TAG, $"Return code {rc} in seacatcc.yield('Q')");
+            }
+        }
+    }
+}
@@ -9,6 +9,7 @@ using SeaCatCSharpClient.Utils;
 using SeaCatCSharpClient.Ping;
 using System.Threading;
 using SeaCatCSharpClient.Interfaces;
+using SeaCatCSharpClient.Http;
 using System.IO;
 using System.Net.Http;
 
@@ -31,11 +32,28 @@ namespace SeaCatCSharpClient.Core {
         public EventWaitHandle IsReadyHandle { get; private set; } = new EventWaitHandle(false, EventResetMode.ManualReset);
         public PingFactory PingFactory { get; private set; }
         public StreamFactory StreamFactory { get; private set; }
+        public HttpCache HttpCache { get; private set; }
+        public OfflineQueue OfflineQueue { get; private set; }
+        public ReachabilityMonitor Reachability { get; private set; }
+        public FatalRecovery FatalRecovery { get; private set; }
+        public IdentityBootstrap Identity { get; private set; }
+        public RequestCoalescer RequestCoalescer { get; private set; }
+        public TimingStatistics TimingStatistics { get; private set; }
+        public KeepaliveScheduler Keepalive { get; private set; }
+
+        /// <summary>
+        /// Incremented on every reset of the gateway connection, streams opened before a reset are gone
+        /// </summary>
+        public int GatewayGeneration => Volatile.Read(ref gatewayGeneration);
 
         // frame consumers, divided by frame version type
         private Dictionary<int, IFrameConsumer> cntlFrameConsumers = new Dictionary<int, IFrameConsumer>();
         // queue of all frame providers
         private BlockingQueue<IFrameProvider> frameProviders;
+        // remaining frames of emitted frame chains, always sent before asking providers again
+        private System.Collections.Generic.Queue<ByteBuffer> chainedFrames = new System.Collections.Generic.Queue<ByteBuffer>();
+
+        private int gatewayGeneration = 0;
 
         // last seacat state
         private string lastState;
@@ -46,6 +64,12 @@ namespace SeaCatCSharpClient.Core {
             FramePool = new FramePool();
             StreamFactory = new StreamFactory();
             PingFactory = new PingFactory();
+            Keepalive = new KeepaliveScheduler(() => PingFactory.PingAsync(this));
+            RequestCoalescer = new RequestCoalescer();
+            TimingStatistics = new TimingStatistics();
+            Reachability = new ReachabilityMonitor(this);
+            FatalRecovery = new FatalRecovery(this);
+            Identity = new IdentityBootstrap(this);
 
             try {
                 Bridge = new SeacatBridge();
@@ -62,6 +86,14 @@ namespace SeaCatCSharpClient.Core {
             int rc = Bridge.init((ISeacatCoreAPI)this, appName, appSuffix ?? "", platform, storageDir); // always
             RC.CheckAndThrowIOException("seacatcc.init", rc);
             lastState = Bridge.state();
+            // an identity from the previous run is picked up here
+            Identity.StateChanged(lastState);
+
+            // response cache lives in the var directory as well
+            HttpCache = new HttpCache(storageDir);
+            HttpCache.Open();
+            // opt-in, the journal is mapped by SeaCatClient.OpenOfflineQueue
+            OfflineQueue = new OfflineQueue(this, storageDir);
 
             // Setup frame provider priority queue with given comparator
             frameProviders = new PriorityBlockingQueue<IFrameProvider>(Comparer<IFrameProvider>.Create((p1, p2) => {
@@ -90,6 +122,9 @@ namespace SeaCatCSharpClient.Core {
 
             // wait for event loop
             eventLoopStarted.WaitOne();
+
+            // network changes are passed to the core from now on
+            Reachability.Start();
         }
 
         /// <summary>
@@ -97,8 +132,11 @@ namespace SeaCatCSharpClient.Core {
         /// </summary>
         public void Shutdown() {
             Logger.Debug(TAG, "Shutdown");
+            Reachability.Stop();
             int rc = Bridge.shutdown();
             RC.CheckAndThrowIOException("seacatcc.shutdown", rc);
+            HttpCache?.Close();
+            OfflineQueue?.Close();
             TaskHelper.AbortTask(ccoreThread);
             if (!ccoreThread.Wait(5000)) {
                 throw new IOException("Core thread is still alive!");
@@ -116,6 +154,44 @@ namespace SeaCatCSharpClient.Core {
                 frameProviders.Enqueue(provider);
             }
 
+            YieldDataToSend();
+        }
+
+        /// <summary>
+        /// Changes priority of the provider, a queued provider is moved to the new position in the queue
+        /// </summary>
+        /// <param name="provider">provider to reprioritize</param>
+        /// <param name="change">action that changes FrameProviderPriority of the provider</param>
+        public void ChangeFrameProviderPriority(IFrameProvider provider, Action change) {
+            lock (frameProviders) {
+                // priority mustn't change while the provider is in the heap
+                bool queued = frameProviders.Contains(provider);
+                if (queued) frameProviders.Remove(provider);
+                change();
+                if (queued) frameProviders.Enqueue(provider);
+            }
+        }
+
+        /// <summary>
+        /// Returns the head of the chain and schedules remaining frames to be written right after it
+        /// Must be called from IFrameProvider.BuildFrame with the returned frame being the result of the method
+        /// </summary>
+        /// <param name="chain">chain to emit</param>
+        /// <returns>head of the chain</returns>
+        public ByteBuffer EmitChain(FrameChain chain) {
+            if (chain.Count > 1) {
+                lock (chainedFrames) {
+                    for (int i = 1; i < chain.Count; i++) {
+                        chainedFrames.Enqueue(chain.Frames[i]);
+                    }
+                }
+                YieldDataToSend();
+            }
+
+            return chain.Head;
+        }
+
+        private void YieldDataToSend() {
             // Yield to C-Core that we have frame to send
             int rc = Bridge.yield((char)RC.SeacatYields.DATA_TO_SEND);
             if ((rc > 7900) && (rc < 8000)) {
@@ -174,17 +250,13 @@ namespace SeaCatCSharpClient.Core {
         /// Creates wrapper for a byte buffer that is to be passed to unmanaged code
         /// </summary>
         /// <returns></returns>
-        private static ByteBuffWrapper CreateWrapper(ByteBuffer buffer) {
+        private ByteBuffWrapper CreateWrapper(ByteBuffer buffer) {
             if (buffer == null) {
                 return null;
             }
 
-            ByteBuffWrapper wrapper = new ByteBuffWrapper();
-            wrapper.data = buffer.Data;
-            wrapper.capacity = buffer.Capacity;
-            wrapper.limit = buffer.Limit;
-            wrapper.position = buffer.Position;
-            return wrapper;
+            // pooled frames keep their wrapper, so that the identity survives the round trip
+            return FramePool.Wrap(buffer);
         }
 
         // =====================================================================================
@@ -220,6 +292,11 @@ namespace SeaCatCSharpClient.Core {
                 var providersToKeep = new List<IFrameProvider>();
 
                 lock (frameProviders) {
+                    // continue with frames of a partially sent chain first
+                    lock (chainedFrames) {
+                        if (chainedFrames.Count > 0) frame = chainedFrames.Dequeue();
+                    }
+
                     while (frame == null) {
                         // find provider that will build the frame
                         IFrameProvider provider = frameProviders.Dequeue();
@@ -244,6 +321,7 @@ namespace SeaCatCSharpClient.Core {
 
                 // flip frame to read mode
                 frame?.Flip();
+                if (frame != null) Keepalive.FrameSent();
                 return CreateWrapper(frame);
 
             } catch (Exception e) {
@@ -270,12 +348,17 @@ namespace SeaCatCSharpClient.Core {
             TaskHelper.CheckInterrupt();
             Logger.Debug(TAG, $"CallbackFrameReceived {frameLength} length, {frameWr.position} position ");
 
-            int pos = frameWr.position;
-            frameWr.position = (pos + frameLength);
+            // find the pooled frame the data were read into
+            ByteBuffer frame = FramePool.Lookup(frameWr.frameId, frameWr.generation);
+            if (frame == null) {
+                Logger.Error(TAG, $"Received frame {frameWr.frameId}:{frameWr.generation} doesn't belong to the pool");
+                return;
+            }
 
-            // prepare buffer for writing (data won't be copied!)
-            ByteBuffer frame = new ByteBuffer(frameWr.data, frameWr.position, frameWr.limit);
+            // prepare buffer for reading (data won't be copied!)
+            frame.Position = frameWr.position + frameLength;
             frame.Flip();
+            Keepalive.FrameReceived();
 
             // get type of frame
             byte fb = frame.GetByte(0);
@@ -301,7 +384,7 @@ namespace SeaCatCSharpClient.Core {
             TaskHelper.CheckInterrupt();
             Logger.Debug(TAG, $"CallbackFrameReturn {frame.data.Length} length, {frame.position} position ");
             // just give the allocated frame back to the frame pool since it is no longer needed
-            FramePool.GiveBack(new ByteBuffer(frame.data, frame.position, frame.limit));
+            FramePool.GiveBack(frame.frameId, frame.generation);
         }
 
         public void CallbackWorkerRequest(char worker) {
@@ -310,17 +393,24 @@ namespace SeaCatCSharpClient.Core {
 
             switch (worker) {
                 case 'P':
-                // call ppkgen worker in a separate thread
-                TaskHelper.CreateTask("PPkGen worker", () => Bridge.ppkgen_worker()).Start();
+                // call ppkgen worker in a separate thread, unless it has been started in advance
+                Identity.GenerateKey();
                 break;
                 case 'C':
-                // create and call csr worker in a separate thread
-                Task CSRWorker = CSR.CreateDefault();
-                CSRWorker?.Start();
+                // submit the CSR prepared in advance or the default one in a separate thread
+                Identity.SubmitCsr();
                 // notify observers
                 var evt = new EventMessage(SeaCatClient.ACTION_SEACAT_CSR_NEEDED);
                 EventDispatcher.Dispatcher.SendBroadcast(evt);
                 break;
+                case 'n':
+                // network is not reachable -> yield 'Q' as soon as it is
+                TaskHelper.CreateTask("Network worker", () => Reachability.NetworkUnreachable()).Start();
+                break;
+                case 'f':
+                // recover from fatal error with a backoff
+                FatalRecovery.Recover();
+                break;
                 default:
                 Logger.Error(TAG, $"Unknown worker requested {worker}");
                 break;
@@ -333,8 +423,9 @@ namespace SeaCatCSharpClient.Core {
             // It will very likely be called in shorter period too (as a result of heart beat triggered by other events)
             PingFactory.HeartBeat(now);
             FramePool.HeartBeat(now);
+            double keepaliveIn = Keepalive.HeartBeat(now);
             // TODO: 26/11/2016 Find the best sleeping interval, can be much longer that 5 seconds, I guess
-            return 5.0; // in seconds
+            return Math.Min(5.0, keepaliveIn); // in seconds
         }
 
         public void CallbackEvloopStarted() {
@@ -347,6 +438,7 @@ namespace SeaCatCSharpClient.Core {
 
         public void CallbackGwconnConnected() {
             Logger.Debug(TAG, "CallbackGwconnConnected");
+            Keepalive.Connected(Bridge.time());
             // notify observers
             var evt = new EventMessage(SeaCatClient.ACTION_SEACAT_GWCONN_CONNECTED);
             EventDispatcher.Dispatcher.SendBroadcast(evt);
@@ -354,7 +446,14 @@ namespace SeaCatCSharpClient.Core {
 
         public void CallbackGwconnReset() {
             Logger.Debug(TAG, "CallbackGwconnReset");
+            // streams that end by the reset below must see the new generation
+            Interlocked.Increment(ref gatewayGeneration);
+            Keepalive.Reset(Bridge.time());
             PingFactory.Reset();
+            // frames of the lost connection must not precede replayed requests on the new one
+            lock (chainedFrames) {
+                while (chainedFrames.Count > 0) FramePool.GiveBack(chainedFrames.Dequeue());
+            }
             StreamFactory.Reset();
             // notify observers
             var evt = new EventMessage(SeaCatClient.ACTION_SEACAT_GWCONN_RESET);
@@ -369,6 +468,7 @@ namespace SeaCatCSharpClient.Core {
             evt.PutExtra(SeaCatClient.EXTRA_STATE, state);
             evt.PutExtra(SeaCatClient.EXTRA_PREV_STATE, lastState);
             EventDispatcher.Dispatcher.SendBroadcast(evt);
+            Identity.StateChanged(state);
 
             if ((lastState[0] != (char)RC.SeacatState.CONNECTING) && (state[0] == (char)RC.SeacatState.CONNECTING)) {
                 ConfigureProxyServer(ProxyHost, ProxyPort);
@@ -382,6 +482,8 @@ namespace SeaCatCSharpClient.Core {
 
             if (isReady) {
                 IsReadyHandle.Set();
+                FatalRecovery.Reset();
+                OfflineQueue?.Drain();
             } else {
                 IsReadyHandle.Reset();
             }
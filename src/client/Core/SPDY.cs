@@ -34,8 +34,20 @@ namespace SeaCatCSharpClient.Core {
         static public byte FLAG_FIN = (byte)0x01;
         static public byte FLAG_UNIDIRECTIONAL = (byte)0x02;
         static public byte FLAG_CSR_NOT_FOUND = (byte)0x80;
+        // ALX1 extension: header block of SYN_STREAM/SYN_REPLY is encoded using HeaderTable
+        static public byte FLAG_ALX1_COMPRESSED_HEADERS = (byte)0x40;
+
+        // Characteristic advertising support of ALX1 header compression to the gateway
+        static public string CHARACTERISTIC_HEADER_COMPRESSION = "ahc";
+        static public string HEADER_COMPRESSION_VERSION = "1";
+
+        // Header field representations of compressed header block
+        private static byte HDR_INDEXED = (byte)0x80;           // 1xxxxxxx: index of name and value
+        private static byte HDR_LITERAL_INDEXED = (byte)0x40;   // 01xxxxxx: name index (or 0 + name), value; added to table
+        private static byte HDR_LITERAL_NEVER = (byte)0x10;     // 0001xxxx: name index (or 0 + name), value; not added to table
 
         static public int RST_STREAM_STATUS_INVALID_STREAM = 2;
+        static public int RST_STREAM_STATUS_CANCEL = 5;
         static public int RST_STREAM_STATUS_STREAM_ALREADY_CLOSED = 9;
 
         /// <summary>
@@ -83,21 +95,23 @@ namespace SeaCatCSharpClient.Core {
         /// <summary>
         /// Builds ALX1 Syn stream frame
         /// </summary>
-        /// <param name="frame">frame to write to</param>
+        /// <param name="frame">frame chain to write to</param>
         /// <param name="streamId">id of the stream</param>
         /// <param name="url">target url</param>
         /// <param name="method">http method</param>
         /// <param name="headers">collection of http headers</param>
         /// <param name="finFlag">indicator whether a fin flag should be appended</param>
         /// <param name="priority">priority</param>
-        public static void BuildALX1SynStream(ByteBuffer frame, int streamId, Uri url, string method, Headers headers, bool finFlag, int priority) {
-            BuildALX1SynStream(frame, streamId, url.Host, method, url.AbsolutePath, headers, finFlag, priority);
+        /// <param name="headerTable">header table for compressed header block, null if headers are sent uncompressed</param>
+        public static void BuildALX1SynStream(FrameChain frame, int streamId, Uri url, string method, Headers headers, bool finFlag, int priority, HeaderTable headerTable) {
+            BuildALX1SynStream(frame, streamId, url.Host, method, url.AbsolutePath, headers, finFlag, priority, headerTable);
         }
 
         /// <summary>
-        /// Builds ALX1 Syn Stream frame
+        /// Builds ALX1 Syn Stream frame at the current position of the chain
+        /// Header block that doesn't fit into a single frame continues in the next frame of the chain
         /// </summary>
-        /// <param name="frame">frame to write to</param>
+        /// <param name="frame">frame chain to write to</param>
         /// <param name="streamId">id of the stream</param>
         /// <param name="host">target host</param>
         /// <param name="method">http method</param>
@@ -105,9 +119,12 @@ namespace SeaCatCSharpClient.Core {
         /// <param name="headers">collection of http headers</param>
         /// <param name="finFlag">indicator whether a fin flag should be appended</param>
         /// <param name="priority">priority</param>
-        public static void BuildALX1SynStream(ByteBuffer frame, int streamId, string host, string method, string path, Headers headers, bool finFlag, int priority) {
+        /// <param name="headerTable">header table for compressed header block, null if headers are sent uncompressed</param>
+        public static void BuildALX1SynStream(FrameChain frame, int streamId, string host, string method, string path, Headers headers, bool finFlag, int priority, HeaderTable headerTable) {
 
             Debug.Assert((streamId & 0x80000000) == 0);
+            // several frames can be built into one chain back to back
+            int start = frame.Position;
 
             frame.PutShort((short)(0x8000 | CNTL_FRAME_VERSION_ALX1));  // Frame Version Type
             frame.PutShort((short)CNTL_TYPE_SYN_STREAM);                // Type
@@ -117,7 +134,7 @@ namespace SeaCatCSharpClient.Core {
             frame.PutByte((byte)((priority & 0x07) << 5));              // Priority
             frame.PutByte((byte)0x00);                                  // Slot (reserved)
 
-            Debug.Assert(frame.Position == 18);
+            Debug.Assert(frame.Position - start == 18);
 
             // Strip .seacat from hosts
             // That's for historical reason (we need to support .seacat extension this way)
@@ -126,28 +143,101 @@ namespace SeaCatCSharpClient.Core {
                 if (lastPeriodPos > 0) host = host.Substring(0, lastPeriodPos);
             }
 
-            AppendVLEString(frame, host);
-            AppendVLEString(frame, method);
-            AppendVLEString(frame, path);
+            if (headerTable != null) {
+                // host, method and path are encoded as pseudo-headers
+                AppendCompressedHeader(frame, headerTable, ":host", host);
+                AppendCompressedHeader(frame, headerTable, ":method", method);
+                AppendCompressedHeader(frame, headerTable, ":path", path);
+            } else {
+                AppendVLEString(frame, host);
+                AppendVLEString(frame, method);
+                AppendVLEString(frame, path);
+            }
 
             for (int i = 0; i < headers.Size; i++) {
                 string header = headers.Name(i);
                 if (header == null) continue;
-                if (header.ToLower() == "host") continue;
-                if (header.ToLower() == "connection") continue;
+                if (HeaderNames.Equals(header, HeaderNames.Host)) continue;
+                if (HeaderNames.Equals(header, HeaderNames.Connection)) continue;
 
                 string value = headers.Value(i);
                 if (value == null) continue;
 
-                AppendVLEString(frame, header);
-                AppendVLEString(frame, value);
+                if (headerTable != null) {
+                    AppendCompressedHeader(frame, headerTable, HeaderNames.ToLower(header), value);
+                } else {
+                    AppendVLEString(frame, header);
+                    AppendVLEString(frame, value);
+                }
             }
 
             // Update length entry
-            int flagLength = frame.Position - HEADER_SIZE;
+            int flagLength = frame.Position - start - HEADER_SIZE;
             Debug.Assert(flagLength < 0x01000000);
             flagLength |= (finFlag ? FLAG_FIN : 0) << 24;
-            frame.PutInt(4, flagLength); // Update length of frame
+            if (headerTable != null) flagLength |= FLAG_ALX1_COMPRESSED_HEADERS << 24;
+            frame.PutInt(start + 4, flagLength); // Update length of frame
+        }
+
+        /// <summary>
+        /// Appends a header using the header table
+        /// Fully matching entries are sent as a single index byte, other headers are added to the table
+        /// except of credentials that are never indexed
+        /// </summary>
+        /// <param name="frame">frame chain to write to</param>
+        /// <param name="headerTable">header table of outbound direction</param>
+        /// <param name="name">lower-case header name</param>
+        /// <param name="value">header value</param>
+        private static void AppendCompressedHeader(FrameChain frame, HeaderTable headerTable, string name, string value) {
+            int nameIndex;
+            int index = headerTable.Find(name, value, out nameIndex);
+
+            if (index > 0 && index <= 0x7F) {
+                frame.PutByte((byte)(HDR_INDEXED | index));
+                return;
+            }
+
+            bool sensitive = (name == "authorization" || name == "cookie");
+            int nameIndexLimit = sensitive ? 0x0F : 0x3F;
+
+            if (nameIndex > 0 && nameIndex <= nameIndexLimit) {
+                frame.PutByte((byte)((sensitive ? HDR_LITERAL_NEVER : HDR_LITERAL_INDEXED) | nameIndex));
+            } else {
+                frame.PutByte(sensitive ? HDR_LITERAL_NEVER : HDR_LITERAL_INDEXED);
+                AppendVLEString(frame, name);
+            }
+            AppendVLEString(frame, value);
+
+            if (!sensitive) headerTable.Add(name, value);
+        }
+
+        /// <summary>
+        /// Parses one header of compressed header block, updating the header table accordingly
+        /// </summary>
+        /// <param name="frame">frame to read from</param>
+        /// <param name="headerTable">header table of inbound direction</param>
+        /// <param name="name">parsed header name</param>
+        /// <param name="value">parsed header value</param>
+        public static void ParseCompressedHeader(ByteBuffer frame, HeaderTable headerTable, out string name, out string value) {
+            byte b = frame.GetByte();
+
+            if ((b & HDR_INDEXED) == HDR_INDEXED) {
+                var entry = headerTable.Get(b & 0x7F);
+                name = entry.Key;
+                value = entry.Value;
+                return;
+            }
+
+            bool indexed = (b & HDR_LITERAL_INDEXED) == HDR_LITERAL_INDEXED;
+            if (!indexed && (b & 0xF0) != HDR_LITERAL_NEVER) {
+                throw new IOException($"Invalid compressed header representation: {b}");
+            }
+
+            int nameIndex = b & (indexed ? 0x3F : 0x0F);
+            name = (nameIndex > 0) ? headerTable.Get(nameIndex).Key : ParseVLEString(frame);
+            value = ParseVLEString(frame);
+
+            if (indexed) headerTable.Add(name, value);
         }
 
         /// <summary>
@@ -163,12 +253,25 @@ namespace SeaCatCSharpClient.Core {
             frame.PutInt(4, flagLength); // Update length of frame
         }
 
+        /// <summary>
+        /// Appends a complete DATA frame, it directly follows the previous frame of the chain on the wire
+        /// </summary>
+        /// <param name="frame">frame chain to write to</param>
+        /// <param name="streamId">stream the data belong to</param>
+        /// <param name="finFlag">indicator whether a FIN flag should be appended</param>
+        public static void AppendDataFrame(FrameChain frame, int streamId, byte[] data, int offset, int length, bool finFlag) {
+            Debug.Assert(length < 0x01000000);
+            frame.PutInt(streamId & 0x7FFFFFFF);
+            frame.PutInt(length | ((finFlag ? FLAG_FIN : 0) << 24));
+            frame.PutBytes(data, offset, length);
+        }
+
         /// <summary>
         /// Appends a UTF8 string
         /// </summary>
-        /// <param name="frame">frame to write to</param>
+        /// <param name="frame">frame chain to write to</param>
         /// <param name="text">text to write</param>
-        private static void AppendVLEString(ByteBuffer frame, String text) {
+        private static void AppendVLEString(FrameChain frame, String text) {
             byte[] bytes;
             try {
                 bytes = System.Text.Encoding.UTF8.GetBytes(text);
@@ -201,12 +304,34 @@ namespace SeaCatCSharpClient.Core {
 
             Debug.Assert(length >= 0);
 
-            byte[] bytes = new byte[length];
-            frame.GetBytes(bytes, frame.Position, length);
+            string output = DecodeString(frame, frame.Position, length);
+            frame.Position += length;
+            return output;
+        }
+
+        /// <summary>
+        /// Skips a VLE string, checking that it fits into the frame
+        /// </summary>
+        /// <returns>false if the string exceeds the frame limit</returns>
+        public static bool SkipVLEString(ByteBuffer frame) {
+            if (frame.Remaining < 1) return false;
+            int length = frame.GetByte() & 0xff;
+            if (length == 0xFF) {
+                if (frame.Remaining < 2) return false;
+                length = frame.GetShort() & 0xffff;
+            }
+
+            if (frame.Remaining < length) return false;
+            frame.Position += length;
+            return true;
+        }
 
+        /// <summary>
+        /// Decodes UTF8 string directly from the frame data
+        /// </summary>
+        public static String DecodeString(ByteBuffer frame, int offset, int length) {
             try {
-                var output = UTF8Encoding.UTF8.GetString(bytes, 0, length);
-                return output;
+                return UTF8Encoding.UTF8.GetString(frame.Data, offset, length);
             } catch (Exception) {
                 return "???";
             }
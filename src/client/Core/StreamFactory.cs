@@ -18,49 +18,109 @@ namespace SeaCatCSharpClient.Core {
 
         private static string TAG = "StreamFactory";
         private IntegerCounter streamIdSequence = new IntegerCounter(1);
-        private Dictionary<int, IStream> streams = new Dictionary<int, IStream>();
+        // live streams and streams cancelled by the client (their late frames are dropped silently)
+        private StreamTable streams = new StreamTable();
         private BlockingQueue<ByteBuffer> outboundFrameQueue = new BlockingQueue<ByteBuffer>();
 
         public StreamFactory() {
         }
 
+        /// <summary>
+        /// True if the gateway replied with a compressed header block, so that requests can be compressed too
+        /// </summary>
+        public bool HeaderCompression { get; private set; } = false;
+
+        /// <summary>
+        /// Header table used to encode SYN_STREAM headers, null until header compression is negotiated
+        /// Accessed from the reactor thread only (frames are built in CallbackWriteReady)
+        /// </summary>
+        public HeaderTable OutboundHeaderTable => HeaderCompression ? outboundHeaderTable : null;
+
+        /// <summary>
+        /// Header table used to decode SYN_REPLY headers
+        /// </summary>
+        public HeaderTable InboundHeaderTable => inboundHeaderTable;
+
+        private HeaderTable outboundHeaderTable = new HeaderTable();
+        private HeaderTable inboundHeaderTable = new HeaderTable();
+
         public int RegisterStream(IStream stream) {
             lock (this) {
-                int streamId = streamIdSequence.GetAndAdd(2);
-                Debug.Assert(!streams.ContainsKey(streamId));
+                // the id is taken only if the stream has been registered
+                int streamId = streamIdSequence.Get();
                 streams.Add(streamId, stream);
+                streamIdSequence.Set(streamId + 2);
                 return streamId;
             }
         }
 
         public void UnregisterStream(int streamId) {
-            lock (this) {
-                streams.Remove(streamId);
+            streams.Remove(streamId);
+        }
+
+        /// <summary>
+        /// Drops the stream and resets it with CANCEL status
+        /// </summary>
+        public void CancelStream(Reactor reactor, int streamId) {
+            if (!streams.Cancel(streamId)) return;
+
+            try {
+                SendRST_STREAM(reactor.FramePool.Borrow("StreamFactory.CancelStream"), reactor, streamId, SPDY.RST_STREAM_STATUS_CANCEL);
+            } catch (IOException e) {
+                Logger.Error(TAG, $"Cannot cancel stream {streamId}: {e.Message}");
             }
         }
 
+        /// <summary>
+        /// Returns true if the frame belongs to a stream cancelled by the client, the stream is forgotten on FIN
+        /// </summary>
+        private bool IsCancelled(int streamId, byte frameFlags) {
+            IStream stream;
+            if (!streams.TryGet(streamId, out stream) || stream != null) return false;
+            if ((frameFlags & SPDY.FLAG_FIN) == SPDY.FLAG_FIN) streams.Remove(streamId);
+            return true;
+        }
+
         /// <summary>
         /// Resets all streams
         /// </summary>
         public void Reset() {
             lock (this) {
-                foreach (var key in streams.Keys) {
-                    var current = streams[key];
+                foreach (var current in streams.Clear()) {
                     current.Reset();
                 }
 
                 streamIdSequence.Set(1);
-                streams.Clear();
+
+                // header tables are valid for a single gateway connection
+                HeaderCompression = false;
+                outboundHeaderTable.Clear();
+                inboundHeaderTable.Clear();
             }
         }
 
-        protected IStream GetStream(int streamId) => streams[streamId];
+        /// <summary>
+        /// Returns the live stream or null; lock-free, a late frame costs a failed probe only
+        /// </summary>
+        protected IStream GetStream(int streamId) {
+            IStream stream;
+            streams.TryGet(streamId, out stream);
+            return stream;
+        }
 
         protected bool ReceivedALX1_SYN_REPLY(Reactor reactor, ByteBuffer frame, int frameLength, byte frameFlags) {
             int streamId = frame.GetInt();
             IStream stream = GetStream(streamId);
 
+            bool compressed = (frameFlags & SPDY.FLAG_ALX1_COMPRESSED_HEADERS) == SPDY.FLAG_ALX1_COMPRESSED_HEADERS;
+            // the gateway understands compressed headers, start compressing requests too
+            if (compressed) HeaderCompression = true;
+
             if (stream == null) {
+                // header table must follow the gateway even if nobody is interested in the reply
+                if (compressed) SkipCompressedHeaders(frame);
+                if (IsCancelled(streamId, frameFlags)) return true;
+
                 Logger.Error(TAG, $"ReceivedALX1_SYN_REPLY stream not found {streamId} (can be closed already)");
                 // reset the stream and send INVALID status
                 frame.Reset();
@@ -75,11 +135,25 @@ namespace SeaCatCSharpClient.Core {
         }
 
 
+        /// <summary>
+        /// Decodes and drops the header block of SYN_REPLY frame, so that the inbound header table stays in sync
+        /// </summary>
+        private void SkipCompressedHeaders(ByteBuffer frame) {
+            string name, value;
+            // status code and reserved 16 bits
+            frame.GetShort();
+            frame.GetShort();
+            while (frame.Position < frame.Limit) {
+                SPDY.ParseCompressedHeader(frame, inboundHeaderTable, out name, out value);
+            }
+        }
+
         protected bool ReceivedSPD3_RST_STREAM(Reactor reactor, ByteBuffer frame, int frameLength, byte frameFlags) {
             int streamId = frame.GetInt();
 
             IStream stream = GetStream(streamId);
             if (stream == null) {
+                IsCancelled(streamId, SPDY.FLAG_FIN);
                 Logger.Error(TAG, $"receivedSPD3_RST_STREAM stream not found: {streamId} (can be closed already)");
                 return true;
             }
@@ -95,6 +169,9 @@ namespace SeaCatCSharpClient.Core {
             IStream stream = GetStream(streamId);
 
             if (stream == null) {
+                // data of a cancelled stream that were already on the way
+                if (IsCancelled(streamId, (byte)(frame.GetInt(frame.Position) >> 24))) return true;
+
                 Logger.Error(TAG, $"ReceivedDataFrame: stream not found: {streamId} (can be closed already)");
                 // reset the stream and send INVALID status
                 frame.Reset();
@@ -0,0 +1,231 @@
+﻿using System;
+using System.Collections.Generic;
+using System.Threading;
+using SeaCatCSharpClient.Interfaces;
+
+namespace SeaCatCSharpClient.Core {
+
+    /// <summary>
+    /// Open-addressed table of streams keyed by stream id, rebuilt when it gets three quarters full
+    /// Lookups are lock-free (reactor thread), modifications are serialized by a lock
+    /// </summary>
+    public class StreamTable {
+
+        public static int DEFAULT_CAPACITY = 1024; // must be a power of two
+
+        /// <summary>
+        /// Immutable slot content; a new one is published for every change, so readers never see a torn entry
+        /// </summary>
+        private class Entry {
+            public readonly int StreamId;
+            public readonly int Generation;
+            // null if the stream has been cancelled and its late frames are to be dropped
+            public readonly IStream Stream;
+
+            public Entry(int streamId, int generation, IStream stream) {
+                this.StreamId = streamId;
+                this.Generation = generation;
+                this.Stream = stream;
+            }
+        }
+
+        /// <summary>
+        /// Slot array with its mask, replaced as a whole when the table grows
+        /// </summary>
+        private class Slots {
+            public readonly Entry[] Entries;
+            public readonly int Mask;
+
+            public Slots(int capacity) {
+                Entries = new Entry[capacity];
+                Mask = capacity - 1;
+            }
+        }
+
+        // removed entry; lookups continue behind it, inserts reuse it
+        private static readonly Entry TOMBSTONE = new Entry(0, -1, null);
+
+        private Slots slots;
+        private readonly object writeLock = new object();
+        // bumped on Clear, entries of previous generations (gateway connections) are stale
+        private int generation = 0;
+        // live and cancelled entries
+        private int count = 0;
+        // the highest stream id added in this generation
+        private int lastStreamId = 0;
+        // number of newer streams after which late frames of a cancelled stream are not expected anymore,
+        // twice the initial capacity; fixed so that the table doesn't grow with the number of cancels
+        private readonly int expiry;
+
+        public StreamTable() : this(DEFAULT_CAPACITY) {
+        }
+
+        public StreamTable(int capacity) {
+            if (capacity <= 0 || (capacity & (capacity - 1)) != 0) throw new ArgumentException("Capacity must be a power of two");
+            slots = new Slots(capacity);
+            expiry = 2 * capacity;
+        }
+
+        public int Count => Volatile.Read(ref count);
+
+        public int Capacity => Volatile.Read(ref slots).Entries.Length;
+
+        /// <summary>
+        /// Client stream ids are odd and sequential, so consecutive streams land in consecutive slots
+        /// </summary>
+        private static int Home(int streamId, int mask) => (streamId >> 1) & mask;
+
+        /// <summary>
+        /// Finds the stream without taking a lock
+        /// </summary>
+        /// <param name="stream">the stream, null if the stream has been cancelled</param>
+        /// <returns>true if the stream id is known (live or cancelled)</returns>
+        public bool TryGet(int streamId, out IStream stream) {
+            int slot;
+            Entry entry = Find(Volatile.Read(ref slots), streamId, out slot);
+            stream = entry?.Stream;
+            return entry != null;
+        }
+
+        public void Add(int streamId, IStream stream) {
+            lock (writeLock) {
+                int slot;
+                if (Find(slots, streamId, out slot) != null) throw new ArgumentException($"Stream {streamId} is already registered");
+
+                if ((count + 1) * 4 > slots.Entries.Length * 3) Rebuild();
+                if (streamId > lastStreamId) lastStreamId = streamId;
+
+                Entry[] entries = slots.Entries;
+                slot = Home(streamId, slots.Mask);
+                for (int i = 0; i < entries.Length; i++, slot = (slot + 1) & slots.Mask) {
+                    Entry entry = entries[slot];
+                    if (entry == null || entry == TOMBSTONE || IsExpired(entry, streamId)) {
+                        Volatile.Write(ref entries[slot], new Entry(streamId, generation, stream));
+                        if (entry == null || entry == TOMBSTONE) count++;
+                        return;
+                    }
+                }
+
+                // unreachable, the table is never full
+                throw new InvalidOperationException("Stream table is full");
+            }
+        }
+
+        /// <summary>
+        /// Keeps the stream id known but drops the stream, so that its late frames can be recognized
+        /// </summary>
+        /// <returns>true if there was a live stream</returns>
+        public bool Cancel(int streamId) {
+            lock (writeLock) {
+                int slot;
+                Entry entry = Find(slots, streamId, out slot);
+                if (entry == null || entry.Stream == null) return false;
+
+                Volatile.Write(ref slots.Entries[slot], new Entry(streamId, generation, null));
+                return true;
+            }
+        }
+
+        /// <summary>
+        /// Removes the stream (live or cancelled)
+        /// </summary>
+        /// <returns>true if the stream id was known</returns>
+        public bool Remove(int streamId) {
+            lock (writeLock) {
+                int slot;
+                if (Find(slots, streamId, out slot) == null) return false;
+
+                Entry[] entries = slots.Entries;
+                Volatile.Write(ref entries[slot], TOMBSTONE);
+                count--;
+
+                // tombstones at the end of a cluster are not needed, no lookup goes past an empty slot anyway
+                if (entries[(slot + 1) & slots.Mask] == null) {
+                    for (int i = 0; i < entries.Length && entries[slot] == TOMBSTONE; i++, slot = (slot - 1) & slots.Mask) {
+                        Volatile.Write(ref entries[slot], null);
+                    }
+                }
+                return true;
+            }
+        }
+
+        /// <summary>
+        /// Removes all streams
+        /// </summary>
+        /// <returns>streams that were live</returns>
+        public List<IStream> Clear() {
+            lock (writeLock) {
+                var live = new List<IStream>();
+                // lookups racing with the clear reject entries of the old generation
+                Interlocked.Increment(ref generation);
+
+                Entry[] entries = slots.Entries;
+                for (int i = 0; i < entries.Length; i++) {
+                    Entry entry = entries[i];
+                    if (entry != null && entry != TOMBSTONE && entry.Stream != null) live.Add(entry.Stream);
+                    Volatile.Write(ref entries[i], null);
+                }
+
+                count = 0;
+                lastStreamId = 0;
+                return live;
+            }
+        }
+
+        /// <summary>
+        /// A cancelled entry may be dropped once it is twice the initial capacity of streams older than given one,
+        /// its late frames are not expected anymore; a recent cancel displaced by a cluster is kept
+        /// </summary>
+        private bool IsExpired(Entry entry, int streamId) {
+            return entry.Stream == null && ((long)streamId - entry.StreamId) >> 1 >= expiry;
+        }
+
+        /// <summary>
+        /// Publishes a new table with entries of the current generation, expired cancelled ones are dropped;
+        /// the capacity is doubled if the table would still be more than half full
+        /// Readers holding the old table still see a consistent, only slightly older, state
+        /// </summary>
+        private void Rebuild() {
+            var kept = new List<Entry>();
+            foreach (Entry entry in slots.Entries) {
+                if (entry == null || entry == TOMBSTONE || entry.Generation != generation) continue;
+                if (!IsExpired(entry, lastStreamId)) kept.Add(entry);
+            }
+
+            int capacity = slots.Entries.Length;
+            if ((kept.Count + 1) * 2 > capacity) capacity *= 2;
+            var grown = new Slots(capacity);
+            int grownCount = 0;
+
+            foreach (Entry entry in kept) {
+
+                int slot = Home(entry.StreamId, grown.Mask);
+                while (grown.Entries[slot] != null) slot = (slot + 1) & grown.Mask;
+                grown.Entries[slot] = entry;
+                grownCount++;
+            }
+
+            count = grownCount;
+            Volatile.Write(ref slots, grown);
+        }
+
+        /// <summary>
+        /// Probes for the slot of given stream, stops at the first empty slot
+        /// </summary>
+        /// <returns>entry of the stream or null</returns>
+        private Entry Find(Slots table, int streamId, out int slot) {
+            int currentGeneration = Volatile.Read(ref generation);
+            Entry[] entries = table.Entries;
+            slot = Home(streamId, table.Mask);
+
+            for (int i = 0; i < entries.Length; i++, slot = (slot + 1) & table.Mask) {
+                Entry entry = Volatile.Read(ref entries[slot]);
+                if (entry == null) break;
+                if (entry.StreamId == streamId && entry.Generation == currentGeneration) return entry;
+            }
+
+            slot = -1;
+            return null;
+        }
+    }
+}
@@ -0,0 +1,143 @@
+﻿using System;
+using System.Net.Http;
+using System.Threading;
+using System.Threading.Tasks;
+using SeaCatCSharpClient.Core;
+using SeaCatCSharpClient.Utils;
+
+namespace SeaCatCSharpClient.Http {
+
+    /// <summary>
+    /// Full-duplex channel of length-delimited messages over a single stream
+    /// Only the opening request carries HTTP headers, then both sides exchange messages concurrently
+    /// </summary>
+    public class Channel : IDisposable {
+
+        private HttpSender sender;
+        private MessageReader reader;
+        // serializes writers, so that messages are never interleaved
+        private SemaphoreSlim writeLock = new SemaphoreSlim(1, 1);
+        private byte[] lengthPrefix = new byte[4];
+        private bool closed = false;
+        // reads messages until the server closes its side, completion is reported by the reader
+        private Task reading = null;
+
+        internal Channel(HttpSender sender, Action<byte[]> messageReceived) {
+            this.sender = sender;
+            this.reader = new MessageReader(messageReceived);
+        }
+
+        /// <summary>
+        /// Response to the opening request
+        /// </summary>
+        public HttpResponseMessage Response { get; private set; }
+
+        /// <summary>
+        /// Completed when the server closes its side of the channel, failed on an error, cancelled by Dispose
+        /// </summary>
+        public Task Completion => reader.Completion;
+
+        /// <summary>
+        /// Sends the opening request and completes once the server accepts the channel
+        /// </summary>
+        internal async Task<Channel> OpenAsync(HttpRequestMessage request, CancellationToken cancellationToken) {
+            Response = await sender.SendAsync(request, cancellationToken).ConfigureAwait(false);
+
+            if (!Response.IsSuccessStatusCode) {
+                sender.Cancel();
+                throw new HttpRequestException($"Channel to {request.RequestUri} refused: {(int)Response.StatusCode}");
+            }
+
+            // the token was meant for opening; from now on the channel is dropped by Dispose
+            sender.ReleaseCancellationToken();
+            // messages may be any time apart
+            sender.InboundStream.ReadTimeoutMillis = Timeout.Infinite;
+            reading = ReadAsync();
+            return this;
+        }
+
+        /// <summary>
+        /// Sends a message
+        /// </summary>
+        /// <param name="message">message to send</param>
+        /// <param name="flush">false to let the message wait for more messages to fill the frame (see Flush)</param>
+        public async Task SendAsync(byte[] message, bool flush = true) {
+            await writeLock.WaitAsync().ConfigureAwait(false);
+            try {
+                OutboundStream stream = sender.OutboundStream;
+                int length = message.Length;
+                lengthPrefix[0] = (byte)(length >> 24);
+                lengthPrefix[1] = (byte)(length >> 16);
+                lengthPrefix[2] = (byte)(length >> 8);
+                lengthPrefix[3] = (byte)length;
+
+                await stream.WriteAsync(lengthPrefix, 0, lengthPrefix.Length, CancellationToken.None).ConfigureAwait(false);
+                await stream.WriteAsync(message, 0, length, CancellationToken.None).ConfigureAwait(false);
+                if (flush) stream.Flush();
+            } finally {
+                writeLock.Release();
+            }
+        }
+
+        /// <summary>
+        /// Sends messages that wait in a partially filled frame
+        /// </summary>
+        public async Task FlushAsync() {
+            await writeLock.WaitAsync().ConfigureAwait(false);
+            try {
+                sender.OutboundStream.Flush();
+            } finally {
+                writeLock.Release();
+            }
+        }
+
+        /// <summary>
+        /// Returns the next message; used when no callback has been given
+        /// </summary>
+        /// <returns>the message or null once the server has closed its side</returns>
+        public Task<byte[]> ReceiveAsync() {
+            return reader.ReceiveAsync();
+        }
+
+        /// <summary>
+        /// Closes the sending side (FIN), messages from the server are still received
+        /// </summary>
+        public async Task CloseAsync() {
+            await writeLock.WaitAsync().ConfigureAwait(false);
+            try {
+                if (closed) return;
+                closed = true;
+                sender.OutboundStream.Dispose();
+            } finally {
+                writeLock.Release();
+            }
+        }
+
+        /// <summary>
+        /// Drops the channel at once (RST_STREAM); if the server has closed its side already, just closes the sending side
+        /// </summary>
+        public void Dispose() {
+            if (reading != null && reading.IsCompleted) {
+                // FIN goes out once a message being written is complete
+                Task close = CloseAsync();
+                return;
+            }
+
+            sender.Cancel();
+            reader.Finish(null, true);
+        }
+
+        private async Task ReadAsync() {
+            try {
+                await reader.ReadAsync(sender.InboundStream).ConfigureAwait(false);
+                reader.Finish(null, false);
+            } catch (OperationCanceledException) {
+                reader.Finish(null, true);
+            } catch (Exception e) {
+                // including a reset of the stream, which must not look like the server closing its side
+                Logger.Error(SeaCatInternals.HTTPTAG, $"Channel failed: {e.Message}");
+                reader.Finish(e, false);
+            }
+        }
+    }
+}
@@ -0,0 +1,194 @@
+﻿using System;
+using System.Collections.Generic;
+using System.IO;
+using System.IO.Compression;
+using System.Linq;
+using System.Text;
+using System.Threading;
+using System.Threading.Tasks;
+using SeaCatCSharpClient.Core;
+using SeaCatCSharpClient.Utils;
+
+namespace SeaCatCSharpClient.Http {
+
+    /// <summary>
+    /// Read-only stream that decodes gzip or deflate encoded response body while the application reads it
+    /// Compressed data are moved from the inbound frames into a small input buffer that the decoder reads asynchronously,
+    /// so no thread is blocked waiting for a frame and neither the compressed nor the decompressed body
+    /// is ever held in memory as a whole
+    /// </summary>
+    public class DecompressingStream : Stream {
+
+        public static string ENCODING_GZIP = "gzip";
+        public static string ENCODING_DEFLATE = "deflate";
+
+        private InboundStream inbound;
+        private string encoding;
+        private CompressedInput input;
+        private Stream decoder = null;
+        private long currentPosition = 0;
+
+        public DecompressingStream(InboundStream inbound, string encoding) {
+            this.inbound = inbound;
+            this.encoding = encoding.Trim().ToLower();
+            this.input = new CompressedInput(inbound);
+        }
+
+        /// <summary>
+        /// Returns true if given content encoding can be decoded by this stream
+        /// </summary>
+        public static bool IsSupported(string encoding) {
+            if (encoding == null) return false;
+            encoding = encoding.Trim().ToLower();
+            return encoding == ENCODING_GZIP || encoding == ENCODING_DEFLATE;
+        }
+
+        public override int Read(byte[] buffer, int offset, int count) {
+            return ReadAsync(buffer, offset, count, CancellationToken.None).GetAwaiter().GetResult();
+        }
+
+        public override async Task<int> ReadAsync(byte[] buffer, int offset, int count, CancellationToken cancellationToken) {
+            if (offset < 0 || count < 0 || offset + count > buffer.Length) throw new IndexOutOfRangeException();
+            if (count == 0) return 0;
+
+            if (decoder == null) decoder = await CreateDecoderAsync(cancellationToken).ConfigureAwait(false);
+
+            // the decoder waits for the next frame through CompressedInput.ReadAsync without blocking a thread
+            int read = await decoder.ReadAsync(buffer, offset, count, cancellationToken).ConfigureAwait(false);
+            currentPosition += read;
+            return read;
+        }
+
+        /// <summary>
+        /// Creates decoder for the content encoding
+        /// HTTP deflate is zlib-wrapped, raw deflate sent by some servers is accepted too
+        /// </summary>
+        private async Task<Stream> CreateDecoderAsync(CancellationToken cancellationToken) {
+            if (encoding == ENCODING_GZIP) {
+                return new GZipStream(input, CompressionMode.Decompress, true);
+            }
+
+            // peek at the zlib header
+            await input.FillAsync(2, cancellationToken).ConfigureAwait(false);
+            bool zlib = (input.Available >= 2) && ((input.Peek(0) & 0x0F) == 8) && ((input.Peek(0) << 8 | input.Peek(1)) % 31 == 0);
+            // raw deflate -> the peeked bytes belong to the deflate data
+            if (zlib) input.Skip(2);
+
+            return new DeflateStream(input, CompressionMode.Decompress, true);
+        }
+
+        protected override void Dispose(bool disposing) {
+            if (disposing) {
+                decoder?.Dispose();
+                inbound.Dispose();
+            }
+            base.Dispose(disposing);
+        }
+
+        public override void Flush() {
+            // nothing to do here
+        }
+
+        public override long Seek(long offset, SeekOrigin origin) {
+            throw new NotImplementedException("Not implemented!");
+        }
+
+        public override void SetLength(long value) {
+            throw new NotImplementedException("Not implemented!");
+        }
+
+        public override void Write(byte[] buffer, int offset, int count) {
+            throw new NotImplementedException("Not implemented!");
+        }
+
+        public override bool CanRead => true; // this stream is read-only
+
+        public override bool CanSeek => false;
+
+        public override bool CanWrite => false;
+
+        public override long Length {
+            get { throw new NotImplementedException("Not implemented!"); }
+        }
+
+        public override long Position {
+            get { return currentPosition; }
+            set { throw new NotImplementedException("Not implemented!"); }
+        }
+
+        /// <summary>
+        /// Compressed bytes taken from the inbound stream ahead of the decoder
+        /// Reads return 0 only at the end of the body, an empty buffer is refilled from the next frame first
+        /// </summary>
+        private class CompressedInput : Stream {
+            private const int CAPACITY = 8192;
+
+            private InboundStream inbound;
+            private byte[] buffer = new byte[CAPACITY];
+            private int start = 0;
+            private int end = 0;
+
+            public CompressedInput(InboundStream inbound) {
+                this.inbound = inbound;
+            }
+
+            public int Available => end - start;
+
+            /// <summary>
+            /// All compressed data have been buffered (FIN)
+            /// </summary>
+            public bool Ended { get; private set; } = false;
+
+            /// <summary>
+            /// Reads from the inbound stream until at least given number of bytes is buffered or the body ends
+            /// </summary>
+            public async Task FillAsync(int minimum, CancellationToken cancellationToken) {
+                if (start == end) start = end = 0;
+                if (start > 0 && CAPACITY - start < minimum) {
+                    Buffer.BlockCopy(buffer, start, buffer, 0, end - start);
+                    end -= start;
+                    start = 0;
+                }
+
+                while (!Ended && Available < minimum) {
+                    int read = await inbound.ReadAsync(buffer, end, CAPACITY - end, cancellationToken).ConfigureAwait(false);
+                    if (read == 0) Ended = true;
+                    end += read;
+                }
+            }
+
+            public byte Peek(int index) => buffer[start + index];
+
+            public void Skip(int count) {
+                start += Math.Min(count, Available);
+            }
+
+            public override int Read(byte[] destination, int offset, int count) {
+                return ReadAsync(destination, offset, count, CancellationToken.None).GetAwaiter().GetResult();
+            }
+
+            public override async Task<int> ReadAsync(byte[] destination, int offset, int count, CancellationToken cancellationToken) {
+                if (count == 0) return 0;
+                if (Available == 0) await FillAsync(1, cancellationToken).ConfigureAwait(false);
+
+                int chunk = Math.Min(count, Available);
+                Buffer.BlockCopy(buffer, start, destination, offset, chunk);
+                start += chunk;
+                return chunk;
+            }
+
+            public override void Flush() { }
+            public override long Seek(long offset, SeekOrigin origin) { throw new NotImplementedException("Not implemented!"); }
+            public override void SetLength(long value) { throw new NotImplementedException("Not implemented!"); }
+            public override void Write(byte[] buffer, int offset, int count) { throw new NotImplementedException("Not implemented!"); }
+            public override bool CanRead => true;
+            public override bool CanSeek => false;
+            public override bool CanWrite => false;
+            public override long Length { get { throw new NotImplementedException("Not implemented!"); } }
+            public override long Position {
+                get { throw new NotImplementedException("Not implemented!"); }
+                set { throw new NotImplementedException("Not implemented!"); }
+            }
+        }
+    }
+}
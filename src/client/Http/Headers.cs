@@ -3,20 +3,98 @@ using System.Collections.Generic;
 using System.Linq;
 using System.Text;
 using System.Threading.Tasks;
+using SeaCatCSharpClient.Core;
+using SeaCatCSharpClient.Utils;
 
 namespace SeaCatCSharpClient.Http {
     /// <summary>
     /// Wrapper for HTTP headers
+    /// Names are matched case-insensitively through precomputed hashes, a name may occur more than once
+    /// Headers of a received frame are decoded lazily, only names and values that are asked for are turned into strings;
+    /// note that HttpSender asks for all of them when it fills the HttpResponseMessage, off the reactor thread
     /// </summary>
     public class Headers {
-        private string[] namesAndValues;
+        private string[] names;
+        private string[] values;
+        private int[] hashes;
+        // hash buckets with index of the last entry of the bucket, entries of the same bucket are chained towards the first one
+        // built on the first lookup
+        private int[] buckets = null;
+        private int[] chain;
+
+        // frame the entries are decoded from and its pool, null once the frame has been released
+        private ByteBuffer frame = null;
+        private FramePool framePool;
+        // offset and length of the name and of the value of each entry in the frame
+        private int[] spans;
 
         private Headers(Builder builder) {
-            this.namesAndValues = builder.namesAndValues.ToArray();
+            this.names = builder.names.ToArray();
+            this.values = builder.values.ToArray();
+            this.hashes = builder.hashes.ToArray();
+        }
+
+        private Headers(ByteBuffer frame, int[] spans, FramePool framePool) {
+            int count = spans.Length / 4;
+            this.names = new string[count];
+            this.values = new string[count];
+            this.frame = frame;
+            this.spans = spans;
+            this.framePool = framePool;
+        }
+
+        /// <summary>
+        /// Creates headers over a block of VLE encoded names and values, the frame is kept until Release is called
+        /// Only lengths are checked here, nothing is decoded
+        /// </summary>
+        /// <returns>headers or null if the block is malformed</returns>
+        public static Headers FromFrame(ByteBuffer frame, FramePool framePool) {
+            int start = frame.Position;
+            int count = 0;
+            while (frame.Position < frame.Limit) {
+                if (!SPDY.SkipVLEString(frame) || !SPDY.SkipVLEString(frame)) return null;
+                count++;
+            }
+
+            int[] spans = new int[count * 4];
+            frame.Position = start;
+            for (int i = 0; i < spans.Length; i += 2) {
+                int length = frame.GetByte() & 0xff;
+                if (length == 0xFF) length = frame.GetShort() & 0xffff;
+                spans[i] = frame.Position;
+                spans[i + 1] = length;
+                frame.Position += length;
+            }
+
+            return new Headers(frame, spans, framePool);
+        }
+
+        /// <summary>
+        /// Decodes all entries that have not been asked for yet and gives the frame back
+        /// </summary>
+        public void Release() {
+            lock (names) {
+                if (frame == null) return;
+                for (int i = 0; i < names.Length; i++) {
+                    Decode(i);
+                }
+
+                framePool.GiveBack(frame);
+                frame = null;
+            }
+        }
+
+        /// <summary>
+        /// Returns the last value of given field or null if there is none
+        /// </summary>
+        public string this[string key] {
+            get {
+                int index = LastIndexOf(key);
+                return index >= 0 ? Value(index) : null;
+            }
         }
 
-        public string this[string key] => Get(namesAndValues, key);
-        public int Size => namesAndValues.Length / 2;
+        public int Size => names.Length;
 
 
         /// <summary>
@@ -24,11 +102,11 @@ namespace SeaCatCSharpClient.Http {
         /// </summary>
         /// <returns></returns>
         public string Name(int index) {
-            int fieldNameIndex = index * 2;
-            if (fieldNameIndex < 0 || fieldNameIndex >= namesAndValues.Length) {
+            if (index < 0 || index >= names.Length) {
                 return null;
             }
-            return namesAndValues[fieldNameIndex];
+            if (names[index] == null && frame != null) Decode(index);
+            return names[index];
         }
 
         /// <summary>
@@ -36,11 +114,11 @@ namespace SeaCatCSharpClient.Http {
         /// </summary>
         /// <returns></returns>
         public string Value(int index) {
-            int valueIndex = index * 2 + 1;
-            if (valueIndex < 0 || valueIndex >= namesAndValues.Length) {
+            if (index < 0 || index >= values.Length) {
                 return null;
             }
-            return namesAndValues[valueIndex];
+            if (values[index] == null && frame != null) Decode(index);
+            return values[index];
         }
 
         /// <summary>
@@ -57,19 +135,22 @@ namespace SeaCatCSharpClient.Http {
         }
 
         /// <summary>
-        /// Returns an immutable case-insensitive set of header values
+        /// Returns all values of given field in the order they have been added
         /// </summary>
         /// <param name="name"></param>
         /// <returns></returns>
         public List<string> Values(string name) {
-            List<string> result = null;
-            for (int i = 0; i < Size; i++) {
-                if ((name == null && Name(i) == null) || (name != null && name.ToLower().Equals(Name(i).ToLower()))) {
-                    if (result == null) result = new List<string>(2);
-                    result.Add(Value(i));
-                }
+            var result = new List<string>(2);
+            int hash = HeaderNames.Hash(name);
+            BuildIndex();
+
+            for (int i = buckets[hash & (buckets.Length - 1)]; i >= 0; i = chain[i]) {
+                if (hashes[i] == hash && HeaderNames.Equals(names[i], name)) result.Add(Value(i));
             }
-            return result != null ? result.ToList() : new List<string>();
+
+            // chain goes from the last entry
+            result.Reverse();
+            return result;
         }
 
 
@@ -81,20 +162,72 @@ namespace SeaCatCSharpClient.Http {
             return result.ToString();
         }
 
-        private static string Get(string[] namesAndValues, string fieldName) {
-            for (int i = namesAndValues.Length - 2; i >= 0; i -= 2) {
-                if (fieldName.ToLower() == namesAndValues[i].ToLower()) {
-                    return namesAndValues[i + 1];
+        private int LastIndexOf(string fieldName) {
+            int hash = HeaderNames.Hash(fieldName);
+            BuildIndex();
+
+            for (int i = buckets[hash & (buckets.Length - 1)]; i >= 0; i = chain[i]) {
+                if (hashes[i] == hash && HeaderNames.Equals(names[i], fieldName)) return i;
+            }
+            return -1;
+        }
+
+        /// <summary>
+        /// Builds hash buckets, names of a received frame are decoded at this point
+        /// </summary>
+        private void BuildIndex() {
+            if (buckets != null) return;
+
+            lock (names) {
+                if (buckets != null) return;
+
+                if (hashes == null) {
+                    hashes = new int[names.Length];
+                    for (int i = 0; i < names.Length; i++) {
+                        hashes[i] = HeaderNames.Hash(Name(i));
+                    }
+                }
+
+                int bucketCount = 8;
+                while (bucketCount < names.Length * 2) bucketCount <<= 1;
+
+                int[] newBuckets = new int[bucketCount];
+                for (int i = 0; i < bucketCount; i++) newBuckets[i] = -1;
+
+                chain = new int[names.Length];
+                for (int i = 0; i < names.Length; i++) {
+                    int bucket = hashes[i] & (bucketCount - 1);
+                    chain[i] = newBuckets[bucket];
+                    newBuckets[bucket] = i;
+                }
+
+                buckets = newBuckets;
+            }
+        }
+
+        /// <summary>
+        /// Decodes name and value of the entry from the frame
+        /// </summary>
+        private void Decode(int index) {
+            lock (names) {
+                if (frame == null) return;
+                int span = index * 4;
+                if (names[index] == null) {
+                    names[index] = HeaderNames.Intern(SPDY.DecodeString(frame, spans[span], spans[span + 1]));
+                }
+                if (values[index] == null) {
+                    values[index] = SPDY.DecodeString(frame, spans[span + 2], spans[span + 3]).Trim();
                 }
             }
-            return null;
         }
 
         /// <summary>
         /// Builder for HTTP header collection
         /// </summary>
         public class Builder {
-            public List<string> namesAndValues = new List<string>(20);
+            internal List<string> names = new List<string>(10);
+            internal List<string> values = new List<string>(10);
+            internal List<int> hashes = new List<int>(10);
 
             /// <summary>
             /// Add an header line containing a field name, a literal colon, and a value
@@ -123,7 +256,7 @@ namespace SeaCatCSharpClient.Http {
             public Builder Add(string fieldName, string value) {
                 if (fieldName == null) return AddLenient(fieldName, value);
                 if (value == null) throw new Exception("value == null");
-                if (fieldName.Count() == 0 || fieldName.IndexOf('\0') != -1 || value.IndexOf('\0') != -1) {
+                if (fieldName.Length == 0 || fieldName.IndexOf('\0') != -1 || value.IndexOf('\0') != -1) {
                     throw new Exception("Unexpected header: " + fieldName + ": " + value);
                 }
                 return AddLenient(fieldName, value);
@@ -137,16 +270,19 @@ namespace SeaCatCSharpClient.Http {
             /// <param name="value">field value</param>
             /// <returns></returns>
             private Builder AddLenient(string fieldName, string value) {
-                namesAndValues.Add(fieldName);
-                namesAndValues.Add(value.Trim());
+                names.Add(HeaderNames.Intern(fieldName));
+                values.Add(value.Trim());
+                hashes.Add(HeaderNames.Hash(fieldName));
                 return this;
             }
 
             public Builder RemoveAll(string fieldName) {
-                for (int i = 0; i < namesAndValues.Count; i += 2) {
-                    if (fieldName.ToLower() == namesAndValues[i].ToLower()) {
-                        namesAndValues.RemoveAt(i); // field name
-                        namesAndValues.RemoveAt(i); // value
+                int hash = HeaderNames.Hash(fieldName);
+                for (int i = names.Count - 1; i >= 0; i--) {
+                    if (hashes[i] == hash && HeaderNames.Equals(names[i], fieldName)) {
+                        names.RemoveAt(i);
+                        values.RemoveAt(i);
+                        hashes.RemoveAt(i);
                     }
                 }
                 return this;
@@ -163,9 +299,10 @@ namespace SeaCatCSharpClient.Http {
             }
             
             public string Get(string fieldName) {
-                for (int i = namesAndValues.Count - 2; i >= 0; i -= 2) {
-                    if (fieldName.ToLower() == namesAndValues[i]) {
-                        return namesAndValues[i + 1];
+                int hash = HeaderNames.Hash(fieldName);
+                for (int i = names.Count - 1; i >= 0; i--) {
+                    if (hashes[i] == hash && HeaderNames.Equals(names[i], fieldName)) {
+                        return values[i];
                     }
                 }
                 return null;
@@ -177,6 +314,142 @@ namespace SeaCatCSharpClient.Http {
         }
     }
 
+    /// <summary>
+    /// Atom table of well-known header names
+    /// Known names are replaced by a single lowercase instance, so that they are compared by reference in most cases
+    /// </summary>
+    public static class HeaderNames {
+        public const string Accept = "accept";
+        public const string AcceptCharset = "accept-charset";
+        public const string AcceptEncoding = "accept-encoding";
+        public const string AcceptLanguage = "accept-language";
+        public const string AcceptRanges = "accept-ranges";
+        public const string Age = "age";
+        public const string Allow = "allow";
+        public const string Authorization = "authorization";
+        public const string CacheControl = "cache-control";
+        public const string Connection = "connection";
+        public const string ContentDisposition = "content-disposition";
+        public const string ContentEncoding = "content-encoding";
+        public const string ContentLanguage = "content-language";
+        public const string ContentLength = "content-length";
+        public const string ContentLocation = "content-location";
+        public const string ContentRange = "content-range";
+        public const string ContentType = "content-type";
+        public const string Cookie = "cookie";
+        public const string Date = "date";
+        public const string ETag = "etag";
+        public const string Expect = "expect";
+        public const string Expires = "expires";
+        public const string Host = "host";
+        public const string IfMatch = "if-match";
+        public const string IfModifiedSince = "if-modified-since";
+        public const string IfNoneMatch = "if-none-match";
+        public const string IfRange = "if-range";
+        public const string IfUnmodifiedSince = "if-unmodified-since";
+        public const string KeepAlive = "keep-alive";
+        public const string LastModified = "last-modified";
+        public const string Link = "link";
+        public const string Location = "location";
+        public const string Pragma = "pragma";
+        public const string Range = "range";
+        public const string Referer = "referer";
+        public const string RetryAfter = "retry-after";
+        public const string Server = "server";
+        public const string SetCookie = "set-cookie";
+        public const string TransferEncoding = "transfer-encoding";
+        public const string UserAgent = "user-agent";
+        public const string Vary = "vary";
+        public const string Via = "via";
+        public const string WwwAuthenticate = "www-authenticate";
+
+        private static string[] WELL_KNOWN = {
+            Accept, AcceptCharset, AcceptEncoding, AcceptLanguage, AcceptRanges, Age, Allow, Authorization, CacheControl,
+            Connection, ContentDisposition, ContentEncoding, ContentLanguage, ContentLength, ContentLocation, ContentRange,
+            ContentType, Cookie, Date, ETag, Expect, Expires, Host, IfMatch, IfModifiedSince, IfNoneMatch, IfRange,
+            IfUnmodifiedSince, KeepAlive, LastModified, Link, Location, Pragma, Range, Referer, RetryAfter, Server,
+            SetCookie, TransferEncoding, UserAgent, Vary, Via, WwwAuthenticate
+        };
+
+        // names that belong to the content header collection
+        private static string[] CONTENT_HEADERS = {
+            Allow, ContentDisposition, ContentEncoding, ContentLanguage, ContentLength, ContentLocation, ContentRange,
+            ContentType, Expires, LastModified
+        };
+
+        private static Dictionary<string, string> atoms = WELL_KNOWN.ToDictionary(name => name, new FieldNameComparator());
+
+        /// <summary>
+        /// Returns the atom of a well-known name or the name itself
+        /// </summary>
+        public static string Intern(string name) {
+            string atom;
+            if (name != null && atoms.TryGetValue(name, out atom)) return atom;
+            return name;
+        }
+
+        /// <summary>
+        /// Returns the name in lowercase, without allocation for atoms and names that are lowercase already
+        /// </summary>
+        public static string ToLower(string name) {
+            name = Intern(name);
+            if (name == null) return null;
+
+            foreach (char c in name) {
+                if (c >= 'A' && c <= 'Z') return name.ToLowerInvariant();
+            }
+            return name;
+        }
+
+        /// <summary>
+        /// Case-insensitive hash of the name, ASCII letters are folded
+        /// </summary>
+        public static int Hash(string name) {
+            if (name == null) return 0;
+
+            uint hash = 2166136261;
+            foreach (char c in name) {
+                char folded = (c >= 'A' && c <= 'Z') ? (char)(c | 0x20) : c;
+                hash = (hash ^ folded) * 16777619;
+            }
+            return (int)hash;
+        }
+
+        /// <summary>
+        /// Case-insensitive comparison of two names
+        /// </summary>
+        public static bool Equals(string a, string b) {
+            if (ReferenceEquals(a, b)) return true;
+            if (a == null || b == null || a.Length != b.Length) return false;
+            return string.Compare(a, b, StringComparison.OrdinalIgnoreCase) == 0;
+        }
+
+        /// <summary>
+        /// Returns true for well-known headers of the content
+        /// </summary>
+        public static bool IsContentHeader(string name) {
+            name = Intern(name);
+            foreach (var contentHeader in CONTENT_HEADERS) {
+                if (ReferenceEquals(name, contentHeader)) return true;
+            }
+            return false;
+        }
+
+        /// <summary>
+        /// Returns true for well-known headers that don't belong to the content
+        /// </summary>
+        public static bool IsResponseHeader(string name) {
+            return name != null && atoms.ContainsKey(name) && !IsContentHeader(name);
+        }
+
+        /// <summary>
+        /// Returns true for headers whose values are product tokens separated by a space instead of a comma
+        /// </summary>
+        public static bool IsProductList(string name) {
+            return Equals(name, UserAgent) || Equals(name, Server);
+        }
+    }
+
     public class FieldNameComparator : IEqualityComparer<string> {
 
         public int compare(string a, string b) {
@@ -192,11 +465,11 @@ namespace SeaCatCSharpClient.Http {
         }
 
         public bool Equals(string x, string y) {
-            return string.Compare(x, y, StringComparison.OrdinalIgnoreCase) == 0;
+            return HeaderNames.Equals(x, y);
         }
 
         public int GetHashCode(string obj) {
-            return obj.GetHashCode();
+            return HeaderNames.Hash(obj);
         }
     };
 }
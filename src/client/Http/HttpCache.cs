@@ -0,0 +1,669 @@
+﻿using System;
+using System.Collections.Generic;
+using System.IO;
+using System.Linq;
+using System.Net;
+using System.Net.Http;
+using System.Text;
+using System.Threading;
+using System.Threading.Tasks;
+using Windows.Storage;
+using SeaCatCSharpBridge;
+using SeaCatCSharpClient.Utils;
+
+namespace SeaCatCSharpClient.Http {
+
+    /// <summary>
+    /// Private (RFC 7234) cache of GET responses, stored in the SeaCat var directory
+    /// The index is a fixed-size table of slots in a memory-mapped file, headers and bodies are kept in separate files
+    /// </summary>
+    public class HttpCache {
+        private static string TAG = "HttpCache";
+
+        public static int DEFAULT_SLOT_COUNT = 1024;
+
+        private static string INDEX_FILE = "httpcache.idx";
+        private static string FOLDER = "httpcache";
+
+        // index layout: header followed by slots
+        private const int MAGIC = 0x43484353; // "SCHC"
+        private const int VERSION = 1;
+        private const int HEADER_SIZE = 16;
+        private const int SLOT_SIZE = 64;
+        // number of slots a key may be placed to, starting at its hash position
+        private const int PROBE_LENGTH = 8;
+        // upper limit of heuristic freshness (RFC 7234, 4.2.2)
+        private static TimeSpan MAX_HEURISTIC_LIFETIME = TimeSpan.FromDays(1);
+
+        private string directory;
+        private int slotCount;
+        private MappedFile index = null;
+        private int nextFileId;
+        private Task<StorageFolder> folder = null;
+
+        public HttpCache(string directory) : this(directory, DEFAULT_SLOT_COUNT) {
+        }
+
+        public HttpCache(string directory, int slotCount) {
+            this.directory = directory;
+            this.slotCount = slotCount;
+        }
+
+        public bool IsOpen => index != null;
+
+        /// <summary>
+        /// Maps the index file, an index of different layout is wiped out
+        /// </summary>
+        public void Open() {
+            lock (this) {
+                if (index != null) return;
+
+                var file = new MappedFile();
+                int rc = file.open($"{directory}\\{INDEX_FILE}", HEADER_SIZE + slotCount * SLOT_SIZE);
+                if (rc != RC.RC_OK) {
+                    Logger.Error(TAG, $"Cannot open cache index, rc={rc}, cache disabled");
+                    return;
+                }
+
+                byte[] header = new byte[HEADER_SIZE];
+                file.read(0, header);
+                if (BitConverter.ToInt32(header, 0) == MAGIC && BitConverter.ToInt32(header, 4) == VERSION
+                    && BitConverter.ToInt32(header, 8) == slotCount) {
+                    nextFileId = BitConverter.ToInt32(header, 12);
+                } else {
+                    Logger.Debug(TAG, "Creating new cache index");
+                    file.write(HEADER_SIZE, new byte[slotCount * SLOT_SIZE]);
+                    nextFileId = 1;
+                    WriteHeader(file);
+                    file.sync();
+                    // files of the previous index can't be reached anymore
+                    ClearFilesAsync();
+                }
+
+                index = file;
+            }
+        }
+
+        /// <summary>
+        /// Flushes and unmaps the index
+        /// </summary>
+        public void Close() {
+            lock (this) {
+                if (index == null) return;
+                index.close();
+                index = null;
+            }
+        }
+
+        /// <summary>
+        /// Finds a stored response for given uri
+        /// </summary>
+        /// <returns>entry with stored headers or null if there is none</returns>
+        public async Task<Entry> LookupAsync(Uri uri) {
+            string key = uri.AbsoluteUri;
+            Slot slot;
+
+            lock (this) {
+                if (index == null) return null;
+                int slotIndex = FindSlot(Hash(key));
+                if (slotIndex < 0) return null;
+
+                slot = ReadSlot(slotIndex);
+                slot.LastUsed = DateTime.UtcNow.Ticks;
+                WriteSlot(slotIndex, slot);
+            }
+
+            var entry = new Entry(uri, slot);
+            try {
+                var file = await (await GetFolderAsync()).GetFileAsync(HeadersFileName(slot.FileId));
+                using (var reader = new StreamReader(await file.OpenStreamForReadAsync(), Encoding.UTF8)) {
+                    // the first line holds the key to detect hash collisions
+                    if (await reader.ReadLineAsync() != key) return null;
+
+                    string line;
+                    while ((line = await reader.ReadLineAsync()) != null) {
+                        int colon = line.IndexOf(':');
+                        if (colon <= 0) continue;
+                        entry.Headers.Add(new KeyValuePair<string, string>(line.Substring(0, colon), line.Substring(colon + 1).Trim()));
+                    }
+                }
+            } catch (FileNotFoundException) {
+                Remove(slot.KeyHash, slot.FileId);
+                return null;
+            }
+
+            return entry;
+        }
+
+        /// <summary>
+        /// Creates a response from the stored entry, the body is read from its file
+        /// </summary>
+        /// <returns>response or null if the body is no longer available</returns>
+        public async Task<HttpResponseMessage> CreateResponseAsync(Entry entry, HttpRequestMessage request) {
+            Stream body;
+            try {
+                var file = await (await GetFolderAsync()).GetFileAsync(BodyFileName(entry.FileId));
+                body = await file.OpenStreamForReadAsync();
+            } catch (FileNotFoundException) {
+                Remove(Hash(entry.Uri.AbsoluteUri), entry.FileId);
+                return null;
+            }
+
+            var response = new HttpResponseMessage((HttpStatusCode)entry.StatusCode);
+            response.Content = new StreamContent(body);
+            response.RequestMessage = request;
+
+            foreach (var header in entry.Headers) {
+                // some headers should be put into content header collection
+                response.Content.Headers.TryAddWithoutValidation(header.Key, header.Value);
+                response.Headers.TryAddWithoutValidation(header.Key, header.Value);
+            }
+
+            response.Headers.Age = entry.Age;
+            Logger.Debug(TAG, $"Response for {entry.Uri} served from cache");
+            return response;
+        }
+
+        /// <summary>
+        /// Updates the entry after a successful revalidation: headers of the 304 response replace the stored ones
+        /// (RFC 7234, 4.3.4) and freshness is calculated from the updated headers
+        /// </summary>
+        public async Task RefreshAsync(Entry entry, HttpResponseMessage notModified) {
+            var responseTime = DateTime.UtcNow;
+
+            var updated = new HashSet<string>(StringComparer.OrdinalIgnoreCase);
+            var headers = new List<KeyValuePair<string, string>>();
+            foreach (var header in GetHeaders(notModified)) {
+                // the length belongs to the 304 response, not to the stored body
+                if (string.Equals(header.Key, "content-length", StringComparison.OrdinalIgnoreCase)) continue;
+                updated.Add(header.Key);
+                headers.Add(header);
+            }
+            // stored age is outdated, the current one comes with the 304 response if any
+            headers.InsertRange(0, entry.Headers.Where(header => !updated.Contains(header.Key)
+                && !string.Equals(header.Key, "age", StringComparison.OrdinalIgnoreCase)));
+
+            DateTime? expires;
+            using (var merged = new HttpResponseMessage(HttpStatusCode.NotModified) { Content = new ByteArrayContent(new byte[0]) }) {
+                foreach (var header in headers) {
+                    merged.Content.Headers.TryAddWithoutValidation(header.Key, header.Value);
+                    merged.Headers.TryAddWithoutValidation(header.Key, header.Value);
+                }
+                expires = GetExpiration(merged, responseTime, true);
+            }
+            if (expires == null) return;
+
+            lock (this) {
+                if (index == null) return;
+                int slotIndex = FindSlot(Hash(entry.Uri.AbsoluteUri));
+                if (slotIndex < 0) return;
+
+                Slot slot = ReadSlot(slotIndex);
+                if (slot.FileId != entry.FileId) return;
+
+                slot.Stored = responseTime.Ticks;
+                slot.Expires = expires.Value.Ticks;
+                WriteSlot(slotIndex, slot);
+                index.sync();
+
+                entry.Stored = responseTime;
+                entry.Expires = expires.Value;
+                entry.Headers.Clear();
+                entry.Headers.AddRange(headers);
+            }
+
+            string key = entry.Uri.AbsoluteUri;
+            try {
+                await WriteHeadersAsync(await GetFolderAsync(), entry.FileId, key, headers);
+            } catch (Exception e) {
+                // the entry is served with the updated headers now, they are lost only with the next lookup
+                Logger.Error(TAG, $"Cannot update headers of {key}: {e.Message}");
+            }
+        }
+
+        /// <summary>
+        /// Stores the response if it is cacheable
+        /// The body is written into the cache while the application reads it and the entry becomes visible once it is read whole
+        /// </summary>
+        /// <returns>given response, with content replaced if it is going to be stored</returns>
+        public async Task<HttpResponseMessage> StoreAsync(HttpResponseMessage response) {
+            var responseTime = DateTime.UtcNow;
+            var expires = GetExpiration(response, responseTime, false);
+            if (expires == null || response.Content == null) return response;
+
+            int fileId;
+            lock (this) {
+                if (index == null) return response;
+                fileId = nextFileId++;
+                if (nextFileId <= 0) nextFileId = 1;
+                WriteHeader(index);
+            }
+
+            string key = response.RequestMessage.RequestUri.AbsoluteUri;
+            Stream bodyFile;
+            try {
+                var storage = await GetFolderAsync();
+
+                await WriteHeadersAsync(storage, fileId, key, GetHeaders(response));
+                bodyFile = await (await storage.CreateFileAsync(BodyFileName(fileId), CreationCollisionOption.ReplaceExisting)).OpenStreamForWriteAsync();
+            } catch (Exception e) {
+                Logger.Error(TAG, $"Cannot store response for {key}: {e.Message}");
+                DeleteFilesAsync(fileId);
+                return response;
+            }
+
+            var slot = new Slot {
+                KeyHash = Hash(key),
+                FileId = fileId,
+                StatusCode = (int)response.StatusCode,
+                Stored = responseTime.Ticks,
+                Expires = expires.Value.Ticks,
+                LastUsed = responseTime.Ticks
+            };
+
+            // replace the content by the one that fills the cache
+            var content = response.Content;
+            var source = await content.ReadAsStreamAsync();
+            response.Content = new StreamContent(new FillingStream(this, slot, source, bodyFile));
+            foreach (var header in content.Headers) {
+                response.Content.Headers.TryAddWithoutValidation(header.Key, header.Value);
+            }
+
+            return response;
+        }
+
+        /// <summary>
+        /// Headers of the response, each of them once with its values joined
+        /// </summary>
+        private static List<KeyValuePair<string, string>> GetHeaders(HttpResponseMessage response) {
+            var headers = new List<KeyValuePair<string, string>>();
+            // custom headers are present in both collections
+            var written = new HashSet<string>(StringComparer.OrdinalIgnoreCase);
+            var all = response.Content != null ? response.Headers.Concat(response.Content.Headers) : response.Headers;
+            foreach (var header in all) {
+                if (!written.Add(header.Key)) continue;
+                headers.Add(new KeyValuePair<string, string>(header.Key, string.Join(", ", header.Value)));
+            }
+            return headers;
+        }
+
+        /// <summary>
+        /// Writes the headers file of the entry: the key on the first line followed by the headers
+        /// </summary>
+        private static async Task WriteHeadersAsync(StorageFolder storage, int fileId, string key, IEnumerable<KeyValuePair<string, string>> headers) {
+            var headersFile = await storage.CreateFileAsync(HeadersFileName(fileId), CreationCollisionOption.ReplaceExisting);
+            using (var writer = new StreamWriter(await headersFile.OpenStreamForWriteAsync(), new UTF8Encoding(false))) {
+                writer.NewLine = "\n";
+                await writer.WriteLineAsync(key);
+                foreach (var header in headers) {
+                    await writer.WriteLineAsync($"{header.Key}: {header.Value}");
+                }
+            }
+        }
+
+        /// <summary>
+        /// Removes the entry for given uri, called for unsafe methods (RFC 7234, 4.4)
+        /// </summary>
+        public void Invalidate(Uri uri) {
+            long keyHash = Hash(uri.AbsoluteUri);
+            int fileId;
+
+            lock (this) {
+                if (index == null) return;
+                int slotIndex = FindSlot(keyHash);
+                if (slotIndex < 0) return;
+                fileId = ReadSlot(slotIndex).FileId;
+            }
+
+            Remove(keyHash, fileId);
+        }
+
+        /// <summary>
+        /// Calculates the time the response stops being fresh
+        /// </summary>
+        /// <param name="revalidated">true for 304 responses that refresh a stored one</param>
+        /// <returns>expiration time or null if the response mustn't be stored</returns>
+        public static DateTime? GetExpiration(HttpResponseMessage response, DateTime responseTime, bool revalidated) {
+            var cacheControl = response.Headers.CacheControl;
+            if (cacheControl != null && cacheControl.NoStore) return null;
+
+            if (!revalidated) {
+                if (response.StatusCode != HttpStatusCode.OK) return null;
+
+                // stored bodies are decoded, so they can't vary on anything else than encoding
+                if (response.Headers.Vary.Any(vary => !string.Equals(vary, "accept-encoding", StringComparison.OrdinalIgnoreCase))) {
+                    return null;
+                }
+            }
+
+            var date = response.Headers.Date?.UtcDateTime ?? responseTime;
+            var lastModified = response.Content?.Headers.LastModified;
+            bool validated = response.Headers.ETag != null || lastModified != null;
+
+            TimeSpan lifetime = TimeSpan.Zero;
+            if (cacheControl != null && cacheControl.NoCache) {
+                lifetime = TimeSpan.Zero;
+            } else if (cacheControl?.MaxAge != null) {
+                lifetime = cacheControl.MaxAge.Value;
+            } else if (response.Content?.Headers.Expires != null) {
+                lifetime = response.Content.Headers.Expires.Value.UtcDateTime - date;
+            } else if (lastModified != null) {
+                // heuristic freshness, a fraction of the time since the last modification
+                lifetime = TimeSpan.FromTicks((date - lastModified.Value.UtcDateTime).Ticks / 10);
+                if (lifetime > MAX_HEURISTIC_LIFETIME) lifetime = MAX_HEURISTIC_LIFETIME;
+            }
+
+            lifetime -= response.Headers.Age ?? TimeSpan.Zero;
+
+            // stale response without validators is of no use
+            if (lifetime <= TimeSpan.Zero && !validated && !revalidated) return null;
+            return responseTime + (lifetime > TimeSpan.Zero ? lifetime : TimeSpan.Zero);
+        }
+
+        /// <summary>
+        /// Makes the filled entry visible, an older entry of the same key is replaced
+        /// </summary>
+        private void Commit(Slot slot, long bodyLength) {
+            slot.BodyLength = bodyLength;
+            int evictedFileId = 0;
+
+            lock (this) {
+                if (index == null) {
+                    evictedFileId = slot.FileId;
+                } else {
+                    int slotIndex = FindSlot(slot.KeyHash);
+                    if (slotIndex < 0) slotIndex = FindVictim(slot.KeyHash);
+
+                    evictedFileId = ReadSlot(slotIndex).FileId;
+                    WriteSlot(slotIndex, slot);
+                    index.sync();
+                }
+            }
+
+            if (evictedFileId != 0) DeleteFilesAsync(evictedFileId);
+            Logger.Debug(TAG, $"Stored entry {slot.FileId}, {bodyLength} bytes");
+        }
+
+        private void Remove(long keyHash, int fileId) {
+            lock (this) {
+                if (index == null) return;
+                int slotIndex = FindSlot(keyHash);
+                if (slotIndex < 0 || ReadSlot(slotIndex).FileId != fileId) return;
+
+                WriteSlot(slotIndex, new Slot());
+                index.sync();
+            }
+
+            DeleteFilesAsync(fileId);
+        }
+
+        /// <summary>
+        /// Returns index of the slot that holds given key or -1
+        /// </summary>
+        private int FindSlot(long keyHash) {
+            int start = (int)((ulong)keyHash % (ulong)slotCount);
+            for (int i = 0; i < PROBE_LENGTH; i++) {
+                int slotIndex = (start + i) % slotCount;
+                Slot slot = ReadSlot(slotIndex);
+                if (slot.FileId != 0 && slot.KeyHash == keyHash) return slotIndex;
+            }
+            return -1;
+        }
+
+        /// <summary>
+        /// Returns index of an empty slot for given key or of the least recently used one
+        /// </summary>
+        private int FindVictim(long keyHash) {
+            int start = (int)((ulong)keyHash % (ulong)slotCount);
+            int victim = start;
+            long victimUsed = long.MaxValue;
+
+            for (int i = 0; i < PROBE_LENGTH; i++) {
+                int slotIndex = (start + i) % slotCount;
+                Slot slot = ReadSlot(slotIndex);
+                if (slot.FileId == 0) return slotIndex;
+                if (slot.LastUsed < victimUsed) {
+                    victim = slotIndex;
+                    victimUsed = slot.LastUsed;
+                }
+            }
+            return victim;
+        }
+
+        private Slot ReadSlot(int slotIndex) {
+            byte[] data = new byte[SLOT_SIZE];
+            index.read(HEADER_SIZE + slotIndex * SLOT_SIZE, data);
+
+            return new Slot {
+                KeyHash = BitConverter.ToInt64(data, 0),
+                FileId = BitConverter.ToInt32(data, 8),
+                StatusCode = BitConverter.ToInt32(data, 12),
+                Stored = BitConverter.ToInt64(data, 16),
+                Expires = BitConverter.ToInt64(data, 24),
+                LastUsed = BitConverter.ToInt64(data, 32),
+                BodyLength = BitConverter.ToInt64(data, 40)
+            };
+        }
+
+        private void WriteSlot(int slotIndex, Slot slot) {
+            byte[] data = new byte[SLOT_SIZE];
+            Buffer.BlockCopy(BitConverter.GetBytes(slot.KeyHash), 0, data, 0, 8);
+            Buffer.BlockCopy(BitConverter.GetBytes(slot.FileId), 0, data, 8, 4);
+            Buffer.BlockCopy(BitConverter.GetBytes(slot.StatusCode), 0, data, 12, 4);
+            Buffer.BlockCopy(BitConverter.GetBytes(slot.Stored), 0, data, 16, 8);
+            Buffer.BlockCopy(BitConverter.GetBytes(slot.Expires), 0, data, 24, 8);
+            Buffer.BlockCopy(BitConverter.GetBytes(slot.LastUsed), 0, data, 32, 8);
+            Buffer.BlockCopy(BitConverter.GetBytes(slot.BodyLength), 0, data, 40, 8);
+            index.write(HEADER_SIZE + slotIndex * SLOT_SIZE, data);
+        }
+
+        private void WriteHeader(MappedFile file) {
+            byte[] header = new byte[HEADER_SIZE];
+            Buffer.BlockCopy(BitConverter.GetBytes(MAGIC), 0, header, 0, 4);
+            Buffer.BlockCopy(BitConverter.GetBytes(VERSION), 0, header, 4, 4);
+            Buffer.BlockCopy(BitConverter.GetBytes(slotCount), 0, header, 8, 4);
+            Buffer.BlockCopy(BitConverter.GetBytes(nextFileId), 0, header, 12, 4);
+            file.write(0, header);
+        }
+
+        /// <summary>
+        /// FNV-1a hash of the key
+        /// </summary>
+        private static long Hash(string key) {
+            ulong hash = 14695981039346656037;
+            foreach (byte b in Encoding.UTF8.GetBytes(key)) {
+                hash ^= b;
+                hash *= 1099511628211;
+            }
+            // zero is never used so that empty slots can't match
+            return hash == 0 ? 1 : (long)hash;
+        }
+
+        private static string HeadersFileName(int fileId) => $"{fileId:x8}.hdr";
+
+        private static string BodyFileName(int fileId) => $"{fileId:x8}.body";
+
+        private Task<StorageFolder> GetFolderAsync() {
+            lock (this) {
+                if (folder == null || folder.IsFaulted) folder = CreateFolderAsync();
+                return folder;
+            }
+        }
+
+        private async Task<StorageFolder> CreateFolderAsync() {
+            var root = await StorageFolder.GetFolderFromPathAsync(directory);
+            return await root.CreateFolderAsync(FOLDER, CreationCollisionOption.OpenIfExists);
+        }
+
+        private async void DeleteFilesAsync(int fileId) {
+            try {
+                var storage = await GetFolderAsync();
+                foreach (var name in new[] { HeadersFileName(fileId), BodyFileName(fileId) }) {
+                    try {
+                        await (await storage.GetFileAsync(name)).DeleteAsync();
+                    } catch (FileNotFoundException) {
+                        // already deleted
+                    }
+                }
+            } catch (Exception e) {
+                Logger.Error(TAG, $"Cannot delete entry {fileId}: {e.Message}");
+            }
+        }
+
+        private async void ClearFilesAsync() {
+            try {
+                foreach (var file in await (await GetFolderAsync()).GetFilesAsync()) {
+                    await file.DeleteAsync();
+                }
+            } catch (Exception e) {
+                Logger.Error(TAG, $"Cannot clear cache folder: {e.Message}");
+            }
+        }
+
+        /// <summary>
+        /// Slot of the index
+        /// </summary>
+        internal class Slot {
+            public long KeyHash;
+            public int FileId;
+            public int StatusCode;
+            public long Stored;
+            public long Expires;
+            public long LastUsed;
+            public long BodyLength;
+        }
+
+        /// <summary>
+        /// Stored response
+        /// </summary>
+        public class Entry {
+            internal Entry(Uri uri, Slot slot) {
+                Uri = uri;
+                FileId = slot.FileId;
+                StatusCode = slot.StatusCode;
+                Stored = new DateTime(slot.Stored, DateTimeKind.Utc);
+                Expires = new DateTime(slot.Expires, DateTimeKind.Utc);
+                BodyLength = slot.BodyLength;
+            }
+
+            public Uri Uri { get; private set; }
+            public int FileId { get; private set; }
+            public int StatusCode { get; private set; }
+            public DateTime Stored { get; internal set; }
+            public DateTime Expires { get; internal set; }
+            public long BodyLength { get; private set; }
+            public List<KeyValuePair<string, string>> Headers { get; } = new List<KeyValuePair<string, string>>();
+
+            public bool IsFresh => DateTime.UtcNow < Expires;
+
+            public TimeSpan Age {
+                get {
+                    var age = DateTime.UtcNow - Stored;
+                    return age > TimeSpan.Zero ? TimeSpan.FromSeconds((long)age.TotalSeconds) : TimeSpan.Zero;
+                }
+            }
+
+            public string ETag => GetHeader("etag");
+
+            public string LastModified => GetHeader("last-modified");
+
+            private string GetHeader(string name) {
+                return Headers.FirstOrDefault(header => string.Equals(header.Key, name, StringComparison.OrdinalIgnoreCase)).Value;
+            }
+        }
+
+        /// <summary>
+        /// Stream that copies the body into the cache while the application reads it
+        /// </summary>
+        private class FillingStream : Stream {
+            private HttpCache cache;
+            private Slot slot;
+            private Stream source;
+            private Stream bodyFile;
+            private long length = 0;
+
+            public FillingStream(HttpCache cache, Slot slot, Stream source, Stream bodyFile) {
+                this.cache = cache;
+                this.slot = slot;
+                this.source = source;
+                this.bodyFile = bodyFile;
+            }
+
+            public override int Read(byte[] buffer, int offset, int count) {
+                return ReadAsync(buffer, offset, count, CancellationToken.None).GetAwaiter().GetResult();
+            }
+
+            public override async Task<int> ReadAsync(byte[] buffer, int offset, int count, CancellationToken cancellationToken) {
+                int read = await source.ReadAsync(buffer, offset, count, cancellationToken).ConfigureAwait(false);
+                if (bodyFile == null || count == 0) return read;
+
+                try {
+                    if (read > 0) {
+                        await bodyFile.WriteAsync(buffer, offset, read).ConfigureAwait(false);
+                        length += read;
+                    } else {
+                        // whole body has been read -> the entry is complete
+                        await bodyFile.FlushAsync().ConfigureAwait(false);
+                        bodyFile.Dispose();
+                        bodyFile = null;
+                        cache.Commit(slot, length);
+                    }
+                } catch (Exception e) {
+                    Logger.Error(TAG, $"Cannot write entry {slot.FileId}: {e.Message}");
+                    Abandon();
+                }
+
+                return read;
+            }
+
+            /// <summary>
+            /// Drops the incomplete entry
+            /// </summary>
+            private void Abandon() {
+                if (bodyFile == null) return;
+                bodyFile.Dispose();
+                bodyFile = null;
+                cache.DeleteFilesAsync(slot.FileId);
+            }
+
+            protected override void Dispose(bool disposing) {
+                if (disposing) {
+                    Abandon();
+                    source.Dispose();
+                }
+                base.Dispose(disposing);
+            }
+
+            public override void Flush() {
+                // nothing to do here
+            }
+
+            public override long Seek(long offset, SeekOrigin origin) {
+                throw new NotImplementedException("Not implemented!");
+            }
+
+            public override void SetLength(long value) {
+                throw new NotImplementedException("Not implemented!");
+            }
+
+            public override void Write(byte[] buffer, int offset, int count) {
+                throw new NotImplementedException("Not implemented!");
+            }
+
+            public override bool CanRead => true; // this stream is read-only
+
+            public override bool CanSeek => false;
+
+            public override bool CanWrite => false;
+
+            public override long Length {
+                get { throw new NotImplementedException("Not implemented!"); }
+            }
+
+            public override long Position {
+                get { return length; }
+                set { throw new NotImplementedException("Not implemented!"); }
+            }
+        }
+    }
+}
@@ -5,6 +5,7 @@ using System.IO;
 using System.Linq;
 using System.Net;
 using System.Net.Http;
+using System.Net.Http.Headers;
 using System.Text;
 using System.Threading;
 using System.Threading.Tasks;
@@ -15,6 +16,7 @@ using SeaCatCSharpClient.Utils;
 using HttpRequestMessage = System.Net.Http.HttpRequestMessage;
 using HttpResponseMessage = System.Net.Http.HttpResponseMessage;
 using HttpStatusCode = System.Net.HttpStatusCode;
+using HttpMethod = System.Net.Http.HttpMethod;
 
 namespace SeaCatCSharpClient.Http {
 
@@ -24,12 +26,40 @@ namespace SeaCatCSharpClient.Http {
     public class SeacatHttpClientHandler : System.Net.Http.HttpClientHandler {
 
         private Reactor reactor;
+        // default priority of requests without RequestPriority.PROPERTY
         private int priority;
         public System.Net.Http.HttpClient HttpClient { get; set; }
 
+        /// <summary>
+        /// Cache of GET responses, null disables caching
+        /// </summary>
+        public HttpCache Cache { get; set; }
+
+        /// <summary>
+        /// Joins identical GET requests in flight, null disables coalescing
+        /// </summary>
+        public RequestCoalescer Coalescer { get; set; }
+
+        /// <summary>
+        /// Shortens the response timeout on fast links, based on the RTT measured by pings
+        /// Only while HttpClient.Timeout is left at its default, a timeout set by the application is kept as it is
+        /// Off by default: the RTT doesn't tell how long the server takes to process a request, so enable it only
+        /// for endpoints known to respond quickly
+        /// </summary>
+        public bool AdaptiveTimeout { get; set; } = false;
+
+        /// <summary>
+        /// Policy of sending requests again after a reset of the gateway connection, null disables replays
+        /// </summary>
+        public RetryPolicy RetryPolicy { get; set; } = new RetryPolicy();
+
         public SeacatHttpClientHandler(Reactor reactor, int priority) {
             this.reactor = reactor;
             this.priority = priority;
+            this.Cache = reactor.HttpCache;
+            this.Coalescer = reactor.RequestCoalescer;
+            // compressed responses are decoded while being read
+            this.AutomaticDecompression = DecompressionMethods.GZip | DecompressionMethods.Deflate;
         }
         
         protected override Task<HttpResponseMessage> SendAsync(HttpRequestMessage request,
@@ -38,8 +68,159 @@ namespace SeaCatCSharpClient.Http {
                 throw new ArgumentException("Http Client mustn't be null!");
             }
 
+            bool cached = PrepareRequest(request);
+
+            Func<HttpRequestMessage, CancellationToken, Task<HttpResponseMessage>> send = SendToGatewayAsync;
+            if (cached && request.Method == HttpMethod.Get) send = SendCachedAsync;
+
+            if (Coalescer != null) {
+                // the shared request is sent on behalf of all waiters, each of them is cancelled on its own
+                // and the request itself once all of them are
+                return Coalescer.SendAsync(request, cancellationToken, send);
+            }
+
+            return send(request, cancellationToken);
+        }
+
+        /// <summary>
+        /// Sends all requests as one batch: their SYN_STREAMs are written back to back by a single frame provider
+        /// Requests of a batch go straight to the gateway, bypassing the response cache and coalescing
+        /// </summary>
+        /// <returns>batch with a response task per request; awaiting the batch waits for all of them</returns>
+        public RequestBatch SendBatch(IEnumerable<HttpRequestMessage> requests, CancellationToken cancellationToken) {
+            if (HttpClient == null) {
+                throw new ArgumentException("Http Client mustn't be null!");
+            }
+
+            var batch = new RequestBatch(reactor, priority);
+            foreach (var request in requests) {
+                PrepareRequest(request);
+                batch.Add(CreateSender(), request, cancellationToken);
+            }
+
+            batch.Send();
+            return batch;
+        }
+
+        /// <summary>
+        /// Opens a long-lived stream that pushes length-delimited messages, see Subscription
+        /// </summary>
+        /// <param name="request">request that opens the stream, sent again after a reset of the gateway connection</param>
+        /// <param name="messageReceived">callback for each message; if null, messages are read by Subscription.ReceiveAsync</param>
+        public Subscription Subscribe(HttpRequestMessage request, Action<byte[]> messageReceived) {
+            if (HttpClient == null) {
+                throw new ArgumentException("Http Client mustn't be null!");
+            }
+
+            var subscription = new Subscription(HttpClient, reactor, request, priority, messageReceived);
+            subscription.Start();
+            return subscription;
+        }
+
+        /// <summary>
+        /// Opens a full-duplex channel of length-delimited messages, see Channel
+        /// </summary>
+        /// <param name="request">request that opens the channel, its content (if any) is ignored</param>
+        /// <param name="messageReceived">callback for each message; if null, messages are read by Channel.ReceiveAsync</param>
+        /// <returns>channel, completed once the server accepts it</returns>
+        public Task<Channel> OpenChannelAsync(HttpRequestMessage request, Action<byte[]> messageReceived, CancellationToken cancellationToken) {
+            if (HttpClient == null) {
+                throw new ArgumentException("Http Client mustn't be null!");
+            }
+
+            var sender = new HttpSender(HttpClient, reactor, priority) { Duplex = true, RecordTimings = false };
+            return new Channel(sender, messageReceived).OpenAsync(request, cancellationToken);
+        }
+
+        /// <summary>
+        /// Adds Accept-Encoding and invalidates the cache entry for unsafe methods
+        /// </summary>
+        /// <returns>true if the cache is in use</returns>
+        private bool PrepareRequest(HttpRequestMessage request) {
+            // advertise supported encodings unless the caller did it already
+            if (AutomaticDecompression != DecompressionMethods.None && !request.Headers.AcceptEncoding.Any()) {
+                if ((AutomaticDecompression & DecompressionMethods.GZip) != 0) {
+                    request.Headers.AcceptEncoding.Add(new StringWithQualityHeaderValue(DecompressingStream.ENCODING_GZIP));
+                }
+                if ((AutomaticDecompression & DecompressionMethods.Deflate) != 0) {
+                    request.Headers.AcceptEncoding.Add(new StringWithQualityHeaderValue(DecompressingStream.ENCODING_DEFLATE));
+                }
+            }
+
+            bool cached = Cache != null && Cache.IsOpen;
+            if (cached && request.Method != HttpMethod.Get && request.Method != HttpMethod.Head && request.Method != HttpMethod.Options) {
+                // unsafe methods invalidate the stored response
+                Cache.Invalidate(request.RequestUri);
+            }
+            return cached;
+        }
+
+        /// <summary>
+        /// Serves the request from the cache if the stored response is fresh, revalidates a stale one
+        /// </summary>
+        private async Task<HttpResponseMessage> SendCachedAsync(HttpRequestMessage request, CancellationToken cancellationToken) {
+            var cacheControl = request.Headers.CacheControl;
+            if (cacheControl != null && cacheControl.NoStore) {
+                return await SendToGatewayAsync(request, cancellationToken);
+            }
+
+            var entry = await Cache.LookupAsync(request.RequestUri);
+            bool revalidate = cacheControl != null && (cacheControl.NoCache || cacheControl.MaxAge == TimeSpan.Zero);
+
+            if (entry != null && entry.IsFresh && !revalidate) {
+                // fresh hit never reaches the gateway
+                var cached = await Cache.CreateResponseAsync(entry, request);
+                if (cached != null) return cached;
+            }
+
+            // stale entry -> make the request conditional unless the caller did it already
+            // the validators go to SYN_STREAM only, the caller's request is left as it is
+            List<KeyValuePair<string, string>> validators = null;
+            if (entry != null && !request.Headers.IfNoneMatch.Any() && request.Headers.IfModifiedSince == null) {
+                validators = new List<KeyValuePair<string, string>>();
+                if (entry.ETag != null) {
+                    validators.Add(new KeyValuePair<string, string>("If-None-Match", entry.ETag));
+                }
+                if (entry.LastModified != null) {
+                    validators.Add(new KeyValuePair<string, string>("If-Modified-Since", entry.LastModified));
+                }
+                if (validators.Count == 0) validators = null;
+            }
+
+            var response = await SendToGatewayAsync(request, cancellationToken, validators);
+
+            if (validators != null && response.StatusCode == HttpStatusCode.NotModified) {
+                // stored response is still valid
+                await Cache.RefreshAsync(entry, response);
+                var cached = await Cache.CreateResponseAsync(entry, request);
+                response.Dispose();
+                if (cached != null) return cached;
+
+                // stored body is gone (the entry has been dropped) -> the caller didn't ask for 304, get the full response
+                response = await SendToGatewayAsync(request, cancellationToken);
+            }
+
+            return await Cache.StoreAsync(response);
+        }
+
+        private Task<HttpResponseMessage> SendToGatewayAsync(HttpRequestMessage request, CancellationToken cancellationToken) {
+            return SendToGatewayAsync(request, cancellationToken, null);
+        }
+
+        private Task<HttpResponseMessage> SendToGatewayAsync(HttpRequestMessage request, CancellationToken cancellationToken,
+            IList<KeyValuePair<string, string>> extraHeaders) {
             // create a new http sender for each request
-            return new HttpSender(HttpClient, reactor, priority).SendAsync(request, cancellationToken);
+            var sender = CreateSender();
+            sender.ExtraHeaders = extraHeaders;
+            return sender.SendAsync(request, cancellationToken);
+        }
+
+        private HttpSender CreateSender() {
+            var sender = new HttpSender(HttpClient, reactor, priority);
+            sender.Decompression = AutomaticDecompression;
+            sender.AdaptiveTimeout = AdaptiveTimeout;
+            sender.RetryPolicy = RetryPolicy;
+            return sender;
         }
     }
 }
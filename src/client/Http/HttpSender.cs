@@ -28,19 +28,89 @@ namespace SeaCatCSharpClient.Http {
 
         public int SenderId { get; set; }
 
+        /// <summary>
+        /// Request bodies of known length up to this size are sent in the same turn as SYN_STREAM
+        /// </summary>
+        public static int SMALL_BODY_THRESHOLD = 4096;
+
+        /// <summary>
+        /// Timeout of HttpClient that hasn't been set by the application
+        /// </summary>
+        private static readonly TimeSpan DEFAULT_CLIENT_TIMEOUT = TimeSpan.FromSeconds(100);
+
+        /// <summary>
+        /// Content encodings that are decoded transparently while the response body is read
+        /// </summary>
+        public DecompressionMethods Decompression { get; set; } = DecompressionMethods.None;
+
+        /// <summary>
+        /// Whether timings of the completed request go into the client statistics (off for long-lived streams)
+        /// </summary>
+        public bool RecordTimings { get; set; } = true;
+
+        /// <summary>
+        /// Whether the response timeout follows the RTT measured by pings, see RttEstimator.GetTimeoutMillis
+        /// Applies only while the timeout of the http client is left at its default
+        /// </summary>
+        public bool AdaptiveTimeout { get; set; } = false;
+
+        /// <summary>
+        /// Requests lost with the gateway connection before the response arrived are sent again if the policy allows it, null disables replays
+        /// </summary>
+        public RetryPolicy RetryPolicy { get; set; } = null;
+
+        /// <summary>
+        /// Headers sent in SYN_STREAM in addition to the request's own ones, the request itself is left untouched
+        /// </summary>
+        internal IList<KeyValuePair<string, string>> ExtraHeaders { get; set; } = null;
+
+        /// <summary>
+        /// The request body is written by the caller through OutboundStream while the response is being read
+        /// </summary>
+        public bool Duplex { get; set; } = false;
+
+        /// <summary>
+        /// Stream of the response body, frames can be read from it directly
+        /// </summary>
+        internal InboundStream InboundStream => inboundStream;
+
+        /// <summary>
+        /// Stream of the request body of a duplex request
+        /// </summary>
+        internal OutboundStream OutboundStream => outboundStream;
+
 
         private Reactor reactor;
         private Uri uri;
         private System.Net.Http.HttpClient client;
         private bool launched = false;
         private InboundStream inboundStream;
+        // small request body that goes out right behind SYN_STREAM instead of the outbound stream, kept for replays
+        private byte[] smallBody = null;
+        // number of times the request has been sent again after a reset of the gateway connection
+        private int replays = 0;
         private OutboundStream outboundStream = null;
-        private Task outboundStreamTask = null;
         
         private int streamId = -1;
+        // request priority 0-7, see RequestPriority
         private int priority;
 
-        private EventWaitHandle responseReady = new EventWaitHandle(false, EventResetMode.ManualReset);
+        // completed by SYN_REPLY (or by reset/timeout), no thread waits for it
+        private TaskCompletionSource<HttpResponseMessage> responseSource = new TaskCompletionSource<HttpResponseMessage>();
+        // cancels the response timeout once the response arrives
+        private CancellationTokenSource responseTimeout = new CancellationTokenSource();
+        private bool responded = false;
+
+        // cancellation by the caller's token or by dropping the response unread; guarded by cancelLock
+        private object cancelLock = new object();
+        private bool cancelled = false;
+        private bool finReceived = false;
+        private CancellationTokenRegistration cancellationRegistration;
+        // streaming of the request body; it ends with an error once the outbound stream is reset by Cancel or Reset
+        private Task upload = null;
+
+        // timestamps of the request phases, published in request properties
+        private RequestTimings timings = new RequestTimings();
         
         // request
         private HttpRequestMessage request;
@@ -67,77 +137,288 @@ namespace SeaCatCSharpClient.Http {
         }
 
         /// <summary>
-        /// Passes asynchronously HTTP request into seacat flow and waits for a response
+        /// Passes asynchronously HTTP request into seacat flow
+        /// The returned task is completed when SYN_REPLY arrives, no thread is blocked meanwhile
         /// </summary>
         /// <param name="request">request to process</param>
         /// <returns></returns>
         public Task<HttpResponseMessage> SendAsync(HttpRequestMessage request,
             CancellationToken cancellationToken) {
+            Task<HttpResponseMessage> response = Prepare(request, cancellationToken);
+            // cancelled before it has been sent
+            if (response.IsCompleted) return response;
+
+            Launch();
+
+            // fail the response if it doesn't arrive in time
+            Task.Delay(GetResponseTimeoutMillis(), responseTimeout.Token).ContinueWith(t => {
+                if (t.IsCanceled) return;
+                ResponseTimedOut();
+            }, TaskContinuationOptions.ExecuteSynchronously);
+
+            return response;
+        }
+
+        /// <summary>
+        /// Prepares the request for sending without registering the sender in the reactor
+        /// SYN_STREAM is then built either by BuildFrame or by AppendSynStream of a batch
+        /// </summary>
+        /// <returns>task completed when SYN_REPLY arrives</returns>
+        internal Task<HttpResponseMessage> Prepare(HttpRequestMessage request, CancellationToken cancellationToken) {
             this.uri = request.RequestUri;
             this.request = request;
+            request.Properties[RequestTimings.PROPERTY] = timings;
+
+            // gaps between frames of the body are not shortened by the RTT
+            int timeoutMillis = GetTimeoutMillis();
 
             // init inbound stream
-            this.inboundStream = new InboundStream(reactor, SenderId, client.Timeout.Milliseconds);
+            this.inboundStream = new InboundStream(reactor, SenderId, timeoutMillis);
+            // response body dropped before it has been read to the end -> stop the transfer
+            this.inboundStream.Abandoned = Cancel;
+
+            if (cancellationToken.IsCancellationRequested) {
+                responseSource.TrySetCanceled();
+                return responseSource.Task;
+            }
+
+            // priority of this request overrides the one of the handler, it can be changed later through RequestPriority.Set
+            // registered only once the request is going to be sent, Detach removes the sender when the request ends
+            lock (request.Properties) {
+                priority = RequestPriority.Get(request, priority);
+                request.Properties[RequestPriority.SENDER] = this;
+            }
 
             // If request has a body, prepare outboundStream too
             HttpContent content = request.Content;
-            if (content != null)
+            if (content != null && !Duplex) smallBody = ReadSmallBody(content);
+
+            if (Duplex) {
+                // the body is written by the caller, the stream stays open until it is closed
+                outboundStream = new OutboundStream(reactor, RequestPriority.ToProviderPriority(priority, true));
+            } else if (content != null && smallBody == null)
             {
-                outboundStream = new OutboundStream(reactor, 1);
-                outboundStream.ContentLength = (int)content.Headers.ContentLength;
-                outboundStreamTask = content.CopyToAsync(outboundStream);
-                TaskHelper.CreateTask("HTTP Outbound Task", () =>
-                {
-                    Task.WaitAll(outboundStreamTask);
-                    outboundStream.Dispose();
-                }).Start();
+                outboundStream = new OutboundStream(reactor, RequestPriority.ToProviderPriority(priority, true));
+                // unknown length is fine, the body is streamed until FIN
+                outboundStream.ContentLength = content.Headers.ContentLength;
+                upload = UploadContentAsync(content, cancellationToken);
             }
 
             Logger.Debug(SeaCatInternals.HTTPTAG, $"H:{SenderId} URI: {this.uri}");
 
-            // run in separate thread
-            var tsk = TaskHelper.CreateTask<HttpResponseMessage>("HTTP Inbound Task", () => {
-                // wait for response stream
-                var inputStream = GetInputStream();
+            cancellationRegistration = cancellationToken.Register(Cancel);
+            timings.Enqueued = reactor.Bridge.time();
+
+            return responseSource.Task;
+        }
+
+        /// <summary>
+        /// Fails the response unless it has arrived already
+        /// </summary>
+        internal void ResponseTimedOut() {
+            if (responseSource.TrySetException(new TimeoutException("Connection timeout"))) {
+                Logger.Error(SeaCatInternals.HTTPTAG, $"H:{SenderId} Reponse didn't arrive!");
+                Detach();
+                Dispose();
+            }
+        }
+
+        /// <summary>
+        /// Removes the reference to this sender from request properties, so that the application holding the request
+        /// doesn't keep the finished sender alive and RequestPriority.Set doesn't reach it anymore
+        /// </summary>
+        private void Detach() {
+            if (request == null) return;
+            lock (request.Properties) {
+                object sender;
+                if (request.Properties.TryGetValue(RequestPriority.SENDER, out sender) && sender == this) {
+                    request.Properties.Remove(RequestPriority.SENDER);
+                }
+            }
+        }
+
+        /// <summary>
+        /// Returns the whole body of a small in-memory content or null if the content has to be streamed
+        /// </summary>
+        private static byte[] ReadSmallBody(HttpContent content) {
+            long? length = content.Headers.ContentLength;
+            if (!(content is ByteArrayContent) || length == null || length > SMALL_BODY_THRESHOLD) return null;
+
+            // byte array content is already in memory, its stream is available synchronously
+            Task<Stream> streamTask = content.ReadAsStreamAsync();
+            if (streamTask.Status != TaskStatus.RanToCompletion) return null;
+
+            Stream source = streamTask.Result;
+            byte[] body = new byte[length.Value];
+            int read = 0, count;
+            while (read < body.Length && (count = source.Read(body, read, body.Length - read)) > 0) {
+                read += count;
+            }
+
+            if (read != body.Length || source.ReadByte() != -1) {
+                // length doesn't match, stream the content instead
+                if (source.CanSeek) source.Position = 0;
+                return null;
+            }
+
+            return body;
+        }
+
+        /// <summary>
+        /// Streams the request body into the outbound stream
+        /// Stream and byte array contents are read directly into pooled frames, other contents serialize themselves into the stream
+        /// </summary>
+        private async Task UploadContentAsync(HttpContent content, CancellationToken cancellationToken) {
+            try {
+                if (content is StreamContent || content is ByteArrayContent) {
+                    Stream source = await content.ReadAsStreamAsync().ConfigureAwait(false);
+                    await outboundStream.UploadAsync(source, cancellationToken).ConfigureAwait(false);
+                } else {
+                    await content.CopyToAsync(outboundStream).ConfigureAwait(false);
+                    // close the stream once the body is written (sends FIN)
+                    outboundStream.Dispose();
+                }
+            } catch (Exception e) {
+                Logger.Error(SeaCatInternals.HTTPTAG, $"H:{SenderId} Error while writing request body: {e.Message}");
+                outboundStream.Reset();
+            }
+        }
+
+        /// <summary>
+        /// Creates response message from received SYN_REPLY
+        /// Called on a thread pool thread to keep the reactor thread free
+        /// HttpResponseMessage header collections can't be filled on demand, so every name and value is decoded here;
+        /// the lazy Headers view only moves the decoding off the reactor thread, it doesn't save allocations
+        /// </summary>
+        private HttpResponseMessage CreateResponse() {
+            // decode compressed body on the fly if the encoding has been requested
+            string contentEncoding = responseHeaders?[HeaderNames.ContentEncoding];
+            bool decode = IsDecoded(contentEncoding);
 
-                // create response
-                this.response = new HttpResponseMessage(responseCode);
-                response.Content = new StreamContent(inputStream);
-                response.RequestMessage = request;
+            // create response
+            this.response = new HttpResponseMessage(responseCode);
+            response.Content = new StreamContent(decode ? new DecompressingStream(inboundStream, contentEncoding) : (Stream)inboundStream);
+            response.RequestMessage = request;
 
 #if DEBUG
-                // for debug purposes, add id of this sender
-                response.Content.Headers.Add("HANDLER-ID", SenderId.ToString());
+            // for debug purposes, add id of this sender
+            response.Content.Headers.Add("HANDLER-ID", SenderId.ToString());
 #endif
 
-                // pass all HTTP headers into output entity
-                if (responseHeaders != null) {
-                    foreach (var name in responseHeaders.Names()) {
-                        // some headers should be put into content header collection
+            // pass all HTTP headers into output entity
+            if (responseHeaders != null) {
+                for (int i = 0; i < responseHeaders.Size; i++) {
+                    string name = responseHeaders.Name(i);
+                    if (name == null) continue;
+
+                    // encoding and length describe the compressed body that the application never sees
+                    if (decode && (HeaderNames.Equals(name, HeaderNames.ContentEncoding) ||
+                        HeaderNames.Equals(name, HeaderNames.ContentLength))) continue;
+
+                    // well-known headers go to their own collection, other ones to both of them
+                    if (!HeaderNames.IsResponseHeader(name)) {
                         response.Content.Headers.TryAddWithoutValidation(name,
-                          responseHeaders[name]);
+                          responseHeaders.Value(i));
+                    }
 
+                    if (!HeaderNames.IsContentHeader(name)) {
                         response.Headers.TryAddWithoutValidation(name,
-                            responseHeaders[name]);
+                            responseHeaders.Value(i));
                     }
                 }
 
-                return response;
-            });
+                // everything has been decoded, the frame is no longer needed
+                responseHeaders.Release();
+            }
+
+            return response;
+        }
+
+        /// <summary>
+        /// Returns true if the body in given content encoding is to be decoded
+        /// </summary>
+        private bool IsDecoded(string contentEncoding) {
+            if (!DecompressingStream.IsSupported(contentEncoding)) return false;
+            bool gzip = contentEncoding.Trim().ToLower() == DecompressingStream.ENCODING_GZIP;
+            return (Decompression & (gzip ? DecompressionMethods.GZip : DecompressionMethods.Deflate)) != 0;
+        }
+
+        /// <summary>
+        /// Completes the response task with current response code and headers
+        /// </summary>
+        private void CompleteResponse() {
+            lock (responseSource) {
+                if (responded) return;
+                responded = true;
+            }
 
-            // run the asynchronous task
-            tsk.Start();
-            return tsk;
+            responseTimeout.Cancel();
+            TaskHelper.SetResultAsync(responseSource, CreateResponse);
         }
         
+        /// <summary>
+        /// The gateway connection has been reset; the request is sent again if possible, otherwise it fails
+        /// </summary>
         public void Reset() {
-            // received reset stream frame -> pass 500 as a response code
+            if (Replay()) return;
+            Fail();
+        }
+
+        /// <summary>
+        /// Sends the request again once the connection is established, unless its response has started to arrive
+        /// The request still has to complete within its original deadline
+        /// </summary>
+        /// <returns>true if the request has been scheduled for sending</returns>
+        private bool Replay() {
+            // streamed body can't be read again
+            if (RetryPolicy == null || outboundStream != null) return false;
+
+            lock (responseSource) {
+                if (responded || responseSource.Task.IsCompleted) return false;
+            }
+
+            lock (cancelLock) {
+                if (cancelled || finReceived || !RetryPolicy.IsReplayable(request, replays)) return false;
+                replays++;
+                // a new stream is registered when SYN_STREAM is built again
+                streamId = -1;
+            }
+
+            timings.Replays = replays;
+            reactor.TimingStatistics.RecordReplay();
+            Logger.Debug(SeaCatInternals.HTTPTAG, $"H:{SenderId} Gateway connection reset, sending request again ({replays})");
+
+            // providers are asked for frames only when the connection is established again
+            reactor.RegisterFrameProvider(this, true);
+            return true;
+        }
+
+        /// <summary>
+        /// Completes the request with 500 as a response code
+        /// </summary>
+        private void Fail() {
             Logger.Debug(SeaCatInternals.HTTPTAG, $"H:{SenderId} Reset stream");
-            Dispose();
+            Detach();
+
+            bool synthetic;
+            lock (responseSource) {
+                synthetic = !responded;
+                if (synthetic) {
+                    responseCode = HttpStatusCode.InternalServerError;
+                    responseMessage = HttpStatus.GetMessage(500);
+                }
+            }
 
-            responseCode = HttpStatusCode.InternalServerError;
-            responseMessage = HttpStatus.GetMessage(500);
-            responseReady.Set();
+            if (!synthetic) {
+                // the body being read is cut off, its reader fails
+                Dispose();
+                return;
+            }
+
+            // the synthetic response has an empty body
+            outboundStream?.Reset();
+            inboundStream.Complete();
+            CompleteResponse();
         }
 
         public void Dispose() {
@@ -145,18 +426,57 @@ namespace SeaCatCSharpClient.Http {
             inboundStream.Reset();
         }
 
+        /// <summary>
+        /// Cancels the request: the stream is reset with CANCEL status, its frames go back to the pool at once
+        /// and the pending response or body read is cancelled
+        /// </summary>
+        public void Cancel() {
+            int cancelledStreamId;
+            lock (cancelLock) {
+                // nothing to cancel once all data arrived
+                if (cancelled || finReceived) return;
+                cancelled = true;
+                cancelledStreamId = streamId;
+            }
+
+            Logger.Debug(SeaCatInternals.HTTPTAG, $"H:{SenderId} Cancelling stream {cancelledStreamId}");
+            responseTimeout.Cancel();
+            TaskHelper.SetCanceledAsync(responseSource);
+            Detach();
+
+            // SYN_STREAM hasn't been sent yet if there is no stream id, BuildFrame won't send it
+            if (cancelledStreamId != -1) reactor.StreamFactory.CancelStream(reactor, cancelledStreamId);
+
+            outboundStream?.Reset();
+            inboundStream.Cancel();
+            cancellationRegistration.Dispose();
+        }
 
         /// <summary>
-        /// Returns a response body
-        /// This is the place where request is isually executed
+        /// Stops cancelling the request by the token given to SendAsync, e.g. once a long-lived stream has been accepted
+        /// The request can still be cancelled by Cancel
         /// </summary>
-        /// <returns></returns>
-        public InboundStream GetInputStream() {
-            Launch();
-            WaitForResponse();
-            return inboundStream;
+        internal void ReleaseCancellationToken() {
+            cancellationRegistration.Dispose();
+        }
+
+        /// <summary>
+        /// Marks that the last frame of the response arrived, the request can't be cancelled anymore
+        /// </summary>
+        private void FinReceived() {
+            lock (cancelLock) {
+                finReceived = true;
+            }
+
+            timings.Finished = reactor.Bridge.time();
+            if (RecordTimings) reactor.TimingStatistics.Record(timings);
+            Detach();
+
+            inboundStream.Complete();
+            cancellationRegistration.Dispose();
         }
 
+
         public string GetRequestProperty(string field) {
             lock (this) {
                 if (field == null) return null;
@@ -169,37 +489,78 @@ namespace SeaCatCSharpClient.Http {
         /// </summary>
         /// <returns></returns>
         public ByteBuffer BuildFrame(Reactor reactor, out bool keep) {
-            lock (this) {
-                Debug.Assert(this.reactor == reactor);
+            Debug.Assert(this.reactor == reactor);
+            keep = false;
+
+            // get a free frame; large header blocks continue in further frames of the chain
+            FrameChain chain = new FrameChain(reactor.FramePool, "HttpClientHandler.buildSYN_STREAM");
+            if (!AppendSynStream(chain)) {
+                chain.GiveBack();
+                return null;
+            }
 
-                // if there is no outbound stream, add FIN FLAG to the current frame
-                bool finFlag = (outboundStream == null);
+            return reactor.EmitChain(chain);
+        }
 
-                // get a free frame
-                ByteBuffer frame = reactor.FramePool.Borrow("HttpClientHandler.buildSYN_STREAM");
+        /// <summary>
+        /// Registers a new stream and appends its SYN_STREAM (and a small body) at the end of the chain
+        /// </summary>
+        /// <returns>false if the request has been cancelled meanwhile and there is nothing to send</returns>
+        internal bool AppendSynStream(FrameChain chain) {
+            lock (this) {
+                // if there is no body to follow, add FIN FLAG to the current frame
+                bool finFlag = (outboundStream == null && smallBody == null);
+
+                // register a new stream unless the request has been cancelled meanwhile
+                lock (cancelLock) {
+                    if (cancelled) return false;
+                    try {
+                        streamId = reactor.StreamFactory.RegisterStream(this);
+                    } catch (Exception e) {
+                        // runs on the reactor thread, the request must fail instead of waiting for its timeout
+                        Logger.Error(SeaCatInternals.HTTPTAG, $"H:{SenderId} Cannot register stream: {e.Message}");
+                        responseTimeout.Cancel();
+                        TaskHelper.SetExceptionAsync(responseSource, e);
+                        Detach();
+                        return false;
+                    }
+                }
 
-                // register a new stream and build the frame
-                streamId = reactor.StreamFactory.RegisterStream(this);
+                // build the frame
                 inboundStream.StreamId = streamId;
-                SPDY.BuildALX1SynStream(frame, streamId, uri, request.Method.Method, GetRequestHeaders(), finFlag, priority);
-
-
-                // If there is an outbound stream, launch that
-                if (outboundStream != null) {
-                    Debug.Assert((frame.GetByte(4) & SPDY.FLAG_FIN) == 0);
+                SPDY.BuildALX1SynStream(chain, streamId, uri, request.Method.Method, GetRequestHeaders(), finFlag, priority,
+                    reactor.StreamFactory.OutboundHeaderTable);
+
+                // If there is a small body, it goes right behind in the same buffer, closing the stream
+                if (smallBody != null) {
+                    SPDY.AppendDataFrame(chain, streamId, smallBody, 0, smallBody.Length, true);
+                    Logger.Debug(SeaCatInternals.HTTPTAG, $"H:{SenderId} Sending SYN with {smallBody.Length} bytes of body and FIN");
+                } else if (outboundStream != null) {
                     outboundStream.Launch(streamId);
                     Logger.Debug(SeaCatInternals.HTTPTAG, $"H:{SenderId} Sending SYN");
                 } else {
                     Logger.Debug(SeaCatInternals.HTTPTAG, $"H:{SenderId} Sending FIN");
-                    Debug.Assert((frame.GetByte(4) & SPDY.FLAG_FIN) == SPDY.FLAG_FIN);
                 }
 
-                keep = false;
-                return frame;
+                timings.SynSent = reactor.Bridge.time();
+                return true;
             }
         }
 
-        public int FrameProviderPriority => priority;
+        public int FrameProviderPriority => RequestPriority.ToProviderPriority(priority, false);
+
+        /// <summary>
+        /// Changes priority of the request in flight
+        /// SYN_STREAM that hasn't been sent yet carries the new priority, frames of the body are rescheduled;
+        /// the gateway is not notified once SYN_STREAM is out since SPDY/3 has no frame for that
+        /// </summary>
+        public void SetPriority(int priority) {
+            priority = RequestPriority.Clamp(priority);
+            Logger.Debug(SeaCatInternals.HTTPTAG, $"H:{SenderId} Priority changed to {priority}");
+
+            reactor.ChangeFrameProviderPriority(this, () => this.priority = priority);
+            outboundStream?.SetPriority(RequestPriority.ToProviderPriority(priority, true));
+        }
 
         public bool ReceivedALX1_SYN_REPLY(Reactor reactor, ByteBuffer frame, int frameLength, byte frameFlags) {
 
@@ -208,6 +569,7 @@ namespace SeaCatCSharpClient.Http {
             lock (this) {
                 //TODO: Check stage - should disregards frames that come prior proper state
                 Logger.Debug(SeaCatInternals.HTTPTAG, $"H:{SenderId} SYN REPLY of length {frameLength} arrived");
+                timings.ReplyReceived = reactor.Bridge.time();
 
                 // get response code and message
                 int respCodeInt = frame.GetShort();
@@ -218,29 +580,42 @@ namespace SeaCatCSharpClient.Http {
                 // Reserved (unused) 16 bits
                 frame.GetShort();
 
-                // Parse response headers
-                Headers.Builder headerBuilder = new Headers.Builder();
+                bool compressed = (frameFlags & SPDY.FLAG_ALX1_COMPRESSED_HEADERS) == SPDY.FLAG_ALX1_COMPRESSED_HEADERS;
+                bool giveBack = true;
 
-                while(frame.Position < frame.Limit) {
-                    string key = SPDY.ParseVLEString(frame);
-                    string val = SPDY.ParseVLEString(frame);
-                    headerBuilder.Add(key, val);
+                if (compressed) {
+                    // compressed block updates the header table, so it has to be decoded here in order
+                    Headers.Builder headerBuilder = new Headers.Builder();
+                    while (frame.Position < frame.Limit) {
+                        string key, val;
+                        SPDY.ParseCompressedHeader(frame, reactor.StreamFactory.InboundHeaderTable, out key, out val);
+                        headerBuilder.Add(key, val);
+                    }
+                    responseHeaders = headerBuilder.Build();
+                } else {
+                    // keep the frame, headers are decoded when the response is created
+                    responseHeaders = Headers.FromFrame(frame, reactor.FramePool);
+                    if (responseHeaders != null) {
+                        giveBack = false;
+                    } else {
+                        Logger.Error(SeaCatInternals.HTTPTAG, $"H:{SenderId} Malformed SYN REPLY headers");
+                        responseHeaders = new Headers.Builder().Build();
+                    }
                 }
 
-                responseHeaders = headerBuilder.Build();
                 // response is now ready
-                responseReady.Set();
+                CompleteResponse();
 
-                if ((frameFlags & SPDY.FLAG_FIN) == SPDY.FLAG_FIN) inboundStream.Dispose();
-                return true;
+                if ((frameFlags & SPDY.FLAG_FIN) == SPDY.FLAG_FIN) FinReceived();
+                return giveBack;
             }
         }
 
         public bool ReceivedSPD3_RST_STREAM(Reactor reactor, ByteBuffer frame, int frameLength, byte frameFlags) {
             lock (this) {
-                // reset stream received
+                // reset stream received, the gateway refused the request -> no replay
                 Logger.Debug(SeaCatInternals.HTTPTAG, $"H:{SenderId} RST STREAM ARRIVED");
-                Reset();
+                Fail();
                 return true;
             }
         }
@@ -249,10 +624,11 @@ namespace SeaCatCSharpClient.Http {
             lock (this) {
                 Logger.Debug(SeaCatInternals.HTTPTAG, $"H:{SenderId} DATA FRAME of length {frameLength} arrived");
                 //TODO: Check stage - should disregards frames that come prior proper state
+                if (double.IsNaN(timings.FirstData)) timings.FirstData = reactor.Bridge.time();
                 bool ret = inboundStream.InboundData(frame);
                 if ((frameFlags & SPDY.FLAG_FIN) == SPDY.FLAG_FIN) {
                     Logger.Debug(SeaCatInternals.HTTPTAG, $"H:{SenderId} FIN detected -> closing stream");
-                    inboundStream.Dispose();
+                    FinReceived();
                 }
                 return ret;
             }
@@ -263,20 +639,28 @@ namespace SeaCatCSharpClient.Http {
             while (enumerator.MoveNext())
             {
                 var key_value = enumerator.Current;
-                var valueEnum = key_value.Value.GetEnumerator();
-                var value = "";
-                while (valueEnum.MoveNext())
-                {
-                    value += valueEnum.Current + " ";
+                if (HeaderNames.IsProductList(key_value.Key)) {
+                    // product tokens make up a single value, separated by a space
+                    requestHeaders.Add(key_value.Key, string.Join(" ", key_value.Value));
+                    continue;
+                }
+
+                // each value is an entry of its own, SYN_STREAM carries the name repeatedly
+                foreach (var value in key_value.Value) {
+                    requestHeaders.Add(key_value.Key, value);
                 }
-                requestHeaders.Add(key_value.Key, value);
             }
         }
 
         public Headers GetRequestHeaders() {
             lock (this) {
+                // built again for every SYN_STREAM (replays)
+                requestHeaders = new Headers.Builder();
                 AddHeaders(this.request.Headers.GetEnumerator());
-                AddHeaders(this.request.Content.Headers.GetEnumerator());
+                if (this.request.Content != null) AddHeaders(this.request.Content.Headers.GetEnumerator());
+                if (ExtraHeaders != null) {
+                    foreach (var header in ExtraHeaders) requestHeaders.Add(header.Key, header.Value);
+                }
                 return requestHeaders.Build();
             }
         }
@@ -293,25 +677,22 @@ namespace SeaCatCSharpClient.Http {
 
 
         /// <summary>
-        /// Blocks and waits for a response from the gateway
-        /// Timeouts using IOException after connection timeout
+        /// Timeout of the body reads, taken from the http client
         /// </summary>
-        protected void WaitForResponse() {
-
-            long timeoutMillis = client.Timeout.Milliseconds;
-            if (timeoutMillis == 0) timeoutMillis = 1000 * 60 * 3; // 3 minutes timeout
-            long cutOfTimeMillis = DateTimeOffset.Now.Millisecond + timeoutMillis;
-
-            responseReady.Reset();
+        internal int GetTimeoutMillis() {
+            double timeoutMillis = client.Timeout.TotalMilliseconds;
+            if (timeoutMillis <= 0 || timeoutMillis > int.MaxValue) timeoutMillis = 1000 * 60 * 3; // 3 minutes timeout
+            return (int)timeoutMillis;
+        }
 
-            try {
-                if (!responseReady.WaitOne(TimeSpan.FromMilliseconds(cutOfTimeMillis))) {
-                    Logger.Error(SeaCatInternals.HTTPTAG, $"H:{SenderId} Reponse didn't arrive!");
-                    throw new TimeoutException("Connection timeout");
-                }
-            } finally {
-                responseReady.Set();
-            }
+        /// <summary>
+        /// Timeout of the response, taken from the http client
+        /// Shortened to fit the measured RTT of the link if AdaptiveTimeout is on and the application hasn't set its own timeout
+        /// </summary>
+        internal int GetResponseTimeoutMillis() {
+            int timeoutMillis = GetTimeoutMillis();
+            if (AdaptiveTimeout && client.Timeout == DEFAULT_CLIENT_TIMEOUT) return reactor.PingFactory.Rtt.GetTimeoutMillis(timeoutMillis);
+            return timeoutMillis;
         }
     }
 }
@@ -16,13 +16,21 @@ namespace SeaCatCSharpClient.Http {
         private Reactor reactor;
         private int currentPosition = 0;
 
-        private BlockingQueue<ByteBuffer> frameQueue = new BlockingQueue<ByteBuffer>();
+        // frames waiting to be read, guarded by the queue itself
+        private System.Collections.Generic.Queue<ByteBuffer> frameQueue = new System.Collections.Generic.Queue<ByteBuffer>();
+        // completed when a frame arrives or the stream is finished; null if nobody waits
+        private TaskCompletionSource<bool> frameWaiter = null;
+        // no more frames will be added to the queue (FIN arrived or the stream has been reset)
+        private bool finished = false;
+        // reading has been cancelled, reads fail instead of reaching the end of the stream
+        private bool cancelled = false;
+        // the stream has been reset before FIN, reads fail instead of reaching the end of the stream
+        private bool reset = false;
         private ByteBuffer currentFrame = null;
         private bool closed = false;
         private int handlerId;
-
-        // dummy buffer for closed queue
-        static private ByteBuffer QUEUE_IS_CLOSED = new ByteBuffer(0);
+        // last synchronously completed read, reused when the same number of bytes is read again
+        private Task<int> lastReadResult = null;
 
         public InboundStream(Reactor reactor, int handlerId, int readTimeoutMillis) {
             this.handlerId = handlerId;
@@ -41,10 +49,29 @@ namespace SeaCatCSharpClient.Http {
         }
 
         public int StreamId { get; set; } = -1;
+        // Timeout.Infinite for long-lived streams that may be silent for any time
         public int ReadTimeoutMillis { get; set; } = 30 * 1000;
 
+        /// <summary>
+        /// Called when the stream is disposed before all data arrived, e.g. the response has been dropped unread
+        /// </summary>
+        public Action Abandoned { get; set; }
+
+        /// <summary>
+        /// True if the stream has been reset (RST_STREAM, lost gateway connection) before FIN arrived
+        /// </summary>
+        public bool WasReset {
+            get {
+                lock (frameQueue) {
+                    return reset;
+                }
+            }
+        }
 
         public bool InboundData(ByteBuffer frame) {
+            // frame raced with the cancellation, the stream has been reset already
+            if (cancelled) return true;
+
             if (closed) {
                 // This stream is closed -> send RST_STREAM back
                 frame.Clear();
@@ -54,79 +81,153 @@ namespace SeaCatCSharpClient.Http {
             }
 
             Logger.Debug(SeaCatInternals.HTTPTAG, $"H:{handlerId} Adding frame of length {frame.Length} into queue");
-            frameQueue.Enqueue(frame);
+            TaskCompletionSource<bool> waiter;
+            lock (frameQueue) {
+                frameQueue.Enqueue(frame);
+                waiter = frameWaiter;
+                frameWaiter = null;
+            }
+
+            // wake up the reader (never on the reactor thread)
+            if (waiter != null) TaskHelper.SetResultAsync(waiter, true);
             return false; // We will return frame to pool on our own
         }
 
+        /// <summary>
+        /// Returns a frame with data to read, blocks until it arrives
+        /// </summary>
+        /// <returns>frame to read from or null if there are no more data</returns>
         public ByteBuffer GetCurrentFrame() {
+            return GetCurrentFrameAsync().GetAwaiter().GetResult();
+        }
 
-            if (currentFrame != null) {
-                if (currentFrame == QUEUE_IS_CLOSED) {
-                    // no frame read
-                    return null;
-                } else if (currentFrame.Remaining == 0) {
-                    // current frame has been already read -> get a new one
-                    reactor.FramePool.GiveBack(currentFrame);
-                    currentFrame = null;
-                } else {
-                    return currentFrame;
-                }
-            }
+        /// <summary>
+        /// Returns a frame with data to read; the returned task completes once the frame arrives
+        /// No thread is blocked while waiting
+        /// </summary>
+        /// <returns>frame to read from or null if there are no more data</returns>
+        /// <exception cref="IOException">the stream has been reset before FIN</exception>
+        public async Task<ByteBuffer> GetCurrentFrameAsync() {
+            long timeoutMillis = this.ReadTimeoutMillis;
+            bool infinite = timeoutMillis == Timeout.Infinite;
+            if (timeoutMillis <= 0) timeoutMillis = 1000 * 60 * 3; // 3 minutes timeout
+            DateTime cutOfTime = DateTime.UtcNow.AddMilliseconds(timeoutMillis);
 
-            // no frame to read -> try to get another one from the queue
+            while (true) {
+                Task<bool> arrival;
 
-            long timeoutMillis = this.ReadTimeoutMillis;
-            if (timeoutMillis == 0) timeoutMillis = 1000 * 60 * 3; // 3 minutes timeout
-            long cutOfTimeMillis = DateTimeOffset.Now.Millisecond + timeoutMillis;
+                lock (frameQueue) {
+                    if (cancelled) throw new OperationCanceledException("Reading of the response has been cancelled");
 
-            while (currentFrame == null) {
+                    while (currentFrame == null || currentFrame.Remaining == 0) {
+                        if (currentFrame != null) {
+                            // current frame has been already read -> get a new one
+                            reactor.FramePool.GiveBack(currentFrame);
+                            currentFrame = null;
+                        }
 
-                TaskHelper.CheckInterrupt();
+                        if (frameQueue.Count == 0) break;
+                        currentFrame = frameQueue.Dequeue();
+                    }
 
-                long awaitMillis = cutOfTimeMillis - DateTimeOffset.Now.Millisecond;
-                if (awaitMillis <= 0) throw new TimeoutException($"Read timeout: {this.ReadTimeoutMillis}");
+                    if (currentFrame != null) return currentFrame;
+                    // no frame read
+                    if (finished) {
+                        if (reset) throw new IOException("Stream has been reset");
+                        return null;
+                    }
 
-                bool success;
-                // try to get a new frame
-                currentFrame = frameQueue.Dequeue((int)awaitMillis, out success);
+                    if (frameWaiter == null) frameWaiter = new TaskCompletionSource<bool>();
+                    arrival = frameWaiter.Task;
+                }
 
-                if (!success) {
-                    TaskHelper.AbortCurrentTask();
+                // no frame to read -> wait for another one to arrive
+                if (infinite) {
+                    await arrival.ConfigureAwait(false);
                     continue;
                 }
 
-                if (currentFrame == QUEUE_IS_CLOSED) {
-                    frameQueue.Enqueue(QUEUE_IS_CLOSED);
-                    currentFrame = null;
-                    break;
+                var awaitTime = cutOfTime - DateTime.UtcNow;
+                if (awaitTime <= TimeSpan.Zero) throw new TimeoutException($"Read timeout: {this.ReadTimeoutMillis}");
+
+                if (!await TaskHelper.WaitAsync(arrival, awaitTime).ConfigureAwait(false)) {
+                    throw new TimeoutException($"Read timeout: {this.ReadTimeoutMillis}");
                 }
             }
-
-            return currentFrame;
         }
 
         protected override void Dispose(bool disposing) {
             if (closed) return;
             closed = true;
-            frameQueue.Enqueue(QUEUE_IS_CLOSED);
+
+            bool abandoned;
+            lock (frameQueue) {
+                abandoned = !finished;
+            }
+
+            Finish();
+            // nobody is going to read the frames anymore
+            GiveBackFrames();
+
+            if (abandoned) Abandoned?.Invoke();
         }
 
+        /// <summary>
+        /// Ends the stream without FIN, pending and further reads fail
+        /// </summary>
         public void Reset() {
-            frameQueue.Enqueue(QUEUE_IS_CLOSED);
+            lock (frameQueue) {
+                if (!finished) reset = true;
+            }
+            Finish();
+            GiveBackFrames();
+            Dispose();
+        }
+
+        /// <summary>
+        /// Marks that all data arrived (FIN), queued frames can still be read
+        /// </summary>
+        public void Complete() {
+            Finish();
+        }
 
-            while (frameQueue.Queue.Count > 1) {
+        /// <summary>
+        /// Cancels the stream, queued frames are given back at once and pending and further reads fail
+        /// </summary>
+        public void Cancel() {
+            lock (frameQueue) {
+                cancelled = true;
+            }
+            Reset();
+        }
+
+        private void GiveBackFrames() {
+            lock (frameQueue) {
                 // give back all frames since they are no longer needed
-                ByteBuffer frame = frameQueue.Dequeue();
-                if (frame != QUEUE_IS_CLOSED) reactor.FramePool.GiveBack(frame);
+                while (frameQueue.Count > 0) {
+                    reactor.FramePool.GiveBack(frameQueue.Dequeue());
+                }
+
+                if (currentFrame != null) {
+                    // return the current one as well
+                    reactor.FramePool.GiveBack(currentFrame);
+                    currentFrame = null;
+                }
             }
+        }
 
-            if (currentFrame != null) {
-                // return the current one as well
-                reactor.FramePool.GiveBack(currentFrame);
-                currentFrame = null;
+        /// <summary>
+        /// Marks the end of the stream and wakes up a waiting reader
+        /// </summary>
+        private void Finish() {
+            TaskCompletionSource<bool> waiter;
+            lock (frameQueue) {
+                finished = true;
+                waiter = frameWaiter;
+                frameWaiter = null;
             }
 
-            Dispose();
+            if (waiter != null) TaskHelper.SetResultAsync(waiter, true);
         }
 
         public override void Flush() {
@@ -141,26 +242,76 @@ namespace SeaCatCSharpClient.Http {
         }
 
         public override int Read(byte[] buffer, int offset, int count) {
+            return ReadAsync(buffer, offset, count, CancellationToken.None).GetAwaiter().GetResult();
+        }
+
+        /// <summary>
+        /// Reads data across all frames that are already queued
+        /// Completes synchronously if there are data available, otherwise waits for the next frame without blocking a thread
+        /// </summary>
+        /// <returns>number of bytes read, 0 at the end of the stream</returns>
+        public override Task<int> ReadAsync(byte[] buffer, int offset, int count, CancellationToken cancellationToken) {
             if (offset < 0 || count < 0 || offset + count > buffer.Length) throw new IndexOutOfRangeException();
 
-            ByteBuffer frame = GetCurrentFrame();
-            if (frame == null) return 0;
+            int read = ReadQueued(buffer, offset, count);
+            if (read > 0 || count == 0) return ReadResult(read);
+
+            return ReadAsyncWhenArrived(buffer, offset, count);
+        }
+
+        private async Task<int> ReadAsyncWhenArrived(byte[] buffer, int offset, int count) {
+            while (true) {
+                // wait for a frame without blocking a thread
+                ByteBuffer frame = await GetCurrentFrameAsync().ConfigureAwait(false);
+                if (frame == null) return 0;
+
+                // nothing read if the frames have been given back by Cancel or Reset meanwhile, the next wait fails
+                int read = ReadQueued(buffer, offset, count);
+                if (read > 0) return read;
+            }
+        }
+
+        /// <summary>
+        /// Copies data from the current frame and consecutive queued frames, never waits
+        /// </summary>
+        private int ReadQueued(byte[] buffer, int offset, int count) {
+            int read = 0;
+
+            lock (frameQueue) {
+                while (read < count) {
+                    if (currentFrame != null && currentFrame.Remaining == 0) {
+                        // current frame has been already read -> get a new one
+                        reactor.FramePool.GiveBack(currentFrame);
+                        currentFrame = null;
+                    }
+
+                    if (currentFrame == null) {
+                        if (frameQueue.Count == 0) break;
+                        currentFrame = frameQueue.Dequeue();
+                        continue;
+                    }
+
+                    int chunk = Math.Min(count - read, currentFrame.Remaining);
+                    currentFrame.Get(buffer, offset + read, chunk);
+                    read += chunk;
+                }
+            }
 
-            if (count > frame.Remaining) count = frame.Remaining;
-            frame.GetBytes(buffer, frame.Position + offset, count);
             // current position is calculated to all frames relatively
-            currentPosition += count;
-            return count;
+            currentPosition += read;
+            return read;
         }
 
-        public override Task<int> ReadAsync(byte[] buffer, int offset, int count, CancellationToken cancellationToken) {
-            var tsk = TaskHelper.CreateTask<int>("Read inbound", () => {
-                Read(buffer, offset, count);
-                return count;
-            });
+        /// <summary>
+        /// Returns a completed task with given result, the last one is reused to avoid allocations
+        /// </summary>
+        private Task<int> ReadResult(int read) {
+            Task<int> task = lastReadResult;
+            if (task != null && task.Result == read) return task;
 
-            tsk.Start();
-            return tsk;
+            task = Task.FromResult(read);
+            lastReadResult = task;
+            return task;
         }
 
         public override int ReadByte() {
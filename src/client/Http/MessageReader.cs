@@ -0,0 +1,138 @@
+﻿using System;
+using System.IO;
+using System.Threading;
+using System.Threading.Tasks;
+using SeaCatCSharpClient.Utils;
+
+namespace SeaCatCSharpClient.Http {
+
+    /// <summary>
+    /// Parses length-delimited messages (32-bit big-endian length followed by the message) directly from incoming frames
+    /// Messages are passed to a callback or queued for ReceiveAsync
+    /// </summary>
+    public class MessageReader {
+
+        public static int MAX_MESSAGE_LENGTH = 16 * 1024 * 1024;
+
+        private Action<byte[]> messageReceived;
+        // messages waiting for ReceiveAsync, guarded by the queue itself
+        private System.Collections.Generic.Queue<byte[]> messages = new System.Collections.Generic.Queue<byte[]>();
+        // completed when a message arrives or the reader finishes; null if nobody waits
+        private TaskCompletionSource<bool> messageWaiter = null;
+        private TaskCompletionSource<bool> completion = new TaskCompletionSource<bool>();
+
+        /// <param name="messageReceived">callback for each message, null to queue messages for ReceiveAsync</param>
+        public MessageReader(Action<byte[]> messageReceived) {
+            this.messageReceived = messageReceived;
+        }
+
+        /// <summary>
+        /// Completed when there are no more messages, failed on an error, cancelled when the reading is cancelled
+        /// </summary>
+        public Task Completion => completion.Task;
+
+        /// <summary>
+        /// Returns the next message
+        /// </summary>
+        /// <returns>the message or null once there are no more messages</returns>
+        public async Task<byte[]> ReceiveAsync() {
+            while (true) {
+                Task<bool> arrival = null;
+
+                lock (messages) {
+                    if (messages.Count > 0) return messages.Dequeue();
+
+                    if (!completion.Task.IsCompleted) {
+                        if (messageWaiter == null) messageWaiter = new TaskCompletionSource<bool>();
+                        arrival = messageWaiter.Task;
+                    }
+                }
+
+                if (arrival == null) {
+                    // rethrows the error
+                    await completion.Task.ConfigureAwait(false);
+                    return null;
+                }
+
+                await arrival.ConfigureAwait(false);
+            }
+        }
+
+        /// <summary>
+        /// Reads messages from the stream until FIN
+        /// Data are copied by InboundStream.ReadAsync under the lock of the stream, so a frame given back by Cancel
+        /// can't be read while it is being reused; the message body is read straight into the message array
+        /// </summary>
+        public async Task ReadAsync(InboundStream stream) {
+            byte[] lengthPrefix = new byte[4];
+
+            while (true) {
+                int lengthBytes = await ReadFullyAsync(stream, lengthPrefix, 0, lengthPrefix.Length).ConfigureAwait(false);
+                if (lengthBytes == 0) return;
+                if (lengthBytes < lengthPrefix.Length) throw new IOException("Stream ended in the middle of a message");
+
+                int length = lengthPrefix[0] << 24 | lengthPrefix[1] << 16 | lengthPrefix[2] << 8 | lengthPrefix[3];
+                if (length < 0 || length > MAX_MESSAGE_LENGTH) throw new IOException($"Message of length {length} is too long");
+
+                byte[] message = new byte[length];
+                if (await ReadFullyAsync(stream, message, 0, length).ConfigureAwait(false) < length) {
+                    throw new IOException("Stream ended in the middle of a message");
+                }
+
+                Deliver(message);
+            }
+        }
+
+        /// <returns>number of bytes read, less than count only at the end of the stream</returns>
+        private static async Task<int> ReadFullyAsync(InboundStream stream, byte[] buffer, int offset, int count) {
+            int filled = 0;
+            while (filled < count) {
+                int read = await stream.ReadAsync(buffer, offset + filled, count - filled, CancellationToken.None).ConfigureAwait(false);
+                if (read == 0) break;
+                filled += read;
+            }
+            return filled;
+        }
+
+        /// <summary>
+        /// Ends the reader, ReceiveAsync returns remaining messages and then null (or the error)
+        /// </summary>
+        public void Finish(Exception error, bool cancelled) {
+            if (cancelled) {
+                completion.TrySetCanceled();
+            } else if (error != null) {
+                completion.TrySetException(error);
+            } else {
+                completion.TrySetResult(true);
+            }
+
+            TaskCompletionSource<bool> waiter;
+            lock (messages) {
+                waiter = messageWaiter;
+                messageWaiter = null;
+            }
+
+            if (waiter != null) TaskHelper.SetResultAsync(waiter, true);
+        }
+
+        private void Deliver(byte[] message) {
+            if (messageReceived != null) {
+                try {
+                    messageReceived(message);
+                } catch (Exception e) {
+                    Logger.Error(SeaCatInternals.HTTPTAG, $"Message callback failed: {e.Message}");
+                }
+                return;
+            }
+
+            TaskCompletionSource<bool> waiter;
+            lock (messages) {
+                messages.Enqueue(message);
+                waiter = messageWaiter;
+                messageWaiter = null;
+            }
+
+            if (waiter != null) TaskHelper.SetResultAsync(waiter, true);
+        }
+    }
+}
@@ -0,0 +1,473 @@
+﻿using System;
+using System.Collections.Generic;
+using System.IO;
+using System.Linq;
+using System.Net.Http;
+using System.Threading;
+using System.Threading.Tasks;
+using SeaCatCSharpBridge;
+using SeaCatCSharpClient.Core;
+using SeaCatCSharpClient.Utils;
+
+namespace SeaCatCSharpClient.Http {
+
+    /// <summary>
+    /// Durable queue of fire-and-forget requests, stored in an append-only journal mapped into memory
+    /// (read and written in place where mmap is not available, see MappedFile)
+    /// Requests are sent in priority order once the gateway connection is established and survive restarts of the app;
+    /// acknowledged records are compacted away into a new journal that replaces the old one
+    /// </summary>
+    public class OfflineQueue {
+        private static string TAG = "OfflineQueue";
+
+        public static int DEFAULT_CAPACITY = 1024 * 1024;
+        // delay before a failed request is sent again, doubled with every failure in a row
+        public static int MIN_RETRY_DELAY_MILLIS = 1000;
+        public static int MAX_RETRY_DELAY_MILLIS = 5 * 60 * 1000;
+
+        private static string JOURNAL_FILE = "offline.jnl";
+        // compacted journal being written
+        private static string TEMPORARY_SUFFIX = ".tmp";
+        // compacted journal complete, replaces the journal
+        private static string COMPACTED_SUFFIX = ".new";
+
+        // journal layout: header followed by records from head to tail
+        private const int MAGIC = 0x514f4353; // "SCOQ"
+        private const int VERSION = 1;
+        // magic, version, capacity, head, tail, next sequence
+        private const int HEADER_SIZE = 24;
+        // payload length, sequence, priority, state
+        private const int RECORD_HEADER_SIZE = 12;
+        private const int STATE_PENDING = 0;
+        private const int STATE_ACKNOWLEDGED = 1;
+
+        private Reactor reactor;
+        private string path;
+        private int capacity;
+        private MappedFile journal = null;
+        private int head;
+        private int tail;
+        private int nextSequence;
+        // pending records in journal order, payloads are read only when the request is sent
+        private List<Record> records = new List<Record>();
+        // journal bytes taken by pending records (with their headers); the rest up to tail is freed by compaction
+        private int pendingBytes = 0;
+        private bool draining = false;
+        private System.Net.Http.HttpClient client = null;
+
+        public OfflineQueue(Reactor reactor, string directory) : this(reactor, directory, DEFAULT_CAPACITY) {
+        }
+
+        public OfflineQueue(Reactor reactor, string directory, int capacity) {
+            this.reactor = reactor;
+            this.path = $"{directory}\\{JOURNAL_FILE}";
+            this.capacity = capacity;
+        }
+
+        public bool IsOpen => journal != null;
+
+        /// <summary>
+        /// Number of requests waiting for sending
+        /// </summary>
+        public int Count {
+            get {
+                lock (this) {
+                    return records.Count;
+                }
+            }
+        }
+
+        /// <summary>
+        /// Maps the journal and picks up requests left by the previous run, a journal of different layout is wiped out
+        /// Only record headers between head and tail are read, the compacted part is skipped
+        /// </summary>
+        public void Open() {
+            lock (this) {
+                if (journal != null) return;
+
+                // compaction interrupted by a crash: a complete compacted journal replaces the old one, a partial one is dropped
+                if (MappedFile.exists(path + COMPACTED_SUFFIX) == RC.RC_OK) {
+                    Logger.Debug(TAG, "Finishing interrupted compaction of offline queue journal");
+                    MappedFile.remove(path);
+                    MappedFile.rename(path + COMPACTED_SUFFIX, path);
+                }
+                MappedFile.remove(path + TEMPORARY_SUFFIX);
+
+                var file = new MappedFile();
+                int rc = file.open(path, capacity);
+                if (rc != RC.RC_OK) {
+                    Logger.Error(TAG, $"Cannot open offline queue journal, rc={rc}, queue disabled");
+                    return;
+                }
+
+                byte[] header = new byte[HEADER_SIZE];
+                file.read(0, header);
+                journal = file;
+
+                if (BitConverter.ToInt32(header, 0) == MAGIC && BitConverter.ToInt32(header, 4) == VERSION
+                    && BitConverter.ToInt32(header, 8) == capacity) {
+                    head = BitConverter.ToInt32(header, 12);
+                    tail = BitConverter.ToInt32(header, 16);
+                    nextSequence = BitConverter.ToInt32(header, 20);
+                    Load();
+                } else {
+                    Logger.Debug(TAG, "Creating new offline queue journal");
+                    head = tail = HEADER_SIZE;
+                    nextSequence = 1;
+                    WriteHeader();
+                    journal.sync();
+                }
+
+                Logger.Debug(TAG, $"Offline queue opened with {records.Count} pending requests");
+            }
+
+            if (reactor.IsReadyHandle.WaitOne(0)) Drain();
+        }
+
+        /// <summary>
+        /// Flushes and unmaps the journal
+        /// </summary>
+        public void Close() {
+            lock (this) {
+                if (journal == null) return;
+                journal.close();
+                journal = null;
+                records.Clear();
+                pendingBytes = 0;
+            }
+        }
+
+        /// <summary>
+        /// Stores the request in the journal; it is sent once the gateway connection is established
+        /// The response is not available, the request is acknowledged by any response other than a server error
+        /// </summary>
+        /// <returns>false if the queue is not open or full</returns>
+        public async Task<bool> EnqueueAsync(HttpRequestMessage request) {
+            byte[] payload = await SerializeAsync(request).ConfigureAwait(false);
+            int priority = RequestPriority.Get(request, RequestPriority.BACKGROUND);
+
+            lock (this) {
+                if (journal == null) return false;
+
+                int length = RECORD_HEADER_SIZE + payload.Length;
+                if (tail + length > capacity) {
+                    // compaction drops only acknowledged records, it is of no use unless they free enough room
+                    if (HEADER_SIZE + pendingBytes + length > capacity) {
+                        Logger.Error(TAG, $"Offline queue is full, request to {request.RequestUri} dropped");
+                        return false;
+                    }
+                    if (!Compact()) return false;
+                }
+
+                var record = new Record(tail, payload.Length, nextSequence++, priority);
+                journal.write(record.Offset + RECORD_HEADER_SIZE, payload);
+                WriteRecordHeader(record, STATE_PENDING);
+                // the record becomes valid with the new tail
+                tail += length;
+                WriteHeader();
+                journal.sync();
+                records.Add(record);
+                pendingBytes += length;
+            }
+
+            if (reactor.IsReadyHandle.WaitOne(0)) Drain();
+            return true;
+        }
+
+        /// <summary>
+        /// Sends queued requests one by one, highest priority first; a failed request is sent again after a growing delay
+        /// Stops when the gateway connection is lost and resumes on the next call, i.e. when it is established again
+        /// </summary>
+        public void Drain() {
+            lock (this) {
+                if (draining || journal == null || records.Count == 0) return;
+                draining = true;
+                if (client == null) {
+                    var handler = new SeacatHttpClientHandler(reactor, RequestPriority.BACKGROUND) { Cache = null, Coalescer = null };
+                    client = new System.Net.Http.HttpClient(handler);
+                    handler.HttpClient = client;
+                }
+            }
+
+            // never on the reactor thread
+            Task.Run(DrainAsync);
+        }
+
+        private async Task DrainAsync() {
+            int retryDelayMillis = MIN_RETRY_DELAY_MILLIS;
+            try {
+                while (true) {
+                    Record record;
+                    byte[] payload;
+
+                    lock (this) {
+                        if (journal == null || records.Count == 0 || !reactor.IsReadyHandle.WaitOne(0)) return;
+                        // lowest priority value first, journal order within the same priority
+                        record = records.OrderBy(r => r.Priority).ThenBy(r => r.Sequence).First();
+                        payload = new byte[record.Length];
+                        journal.read(record.Offset + RECORD_HEADER_SIZE, payload);
+                    }
+
+                    if (!await SendAsync(record, payload).ConfigureAwait(false)) {
+                        // the server or the link may recover while connected, don't wait for the next connection
+                        Logger.Debug(TAG, $"Sending record {record.Sequence} again in {retryDelayMillis}ms");
+                        await Task.Delay(retryDelayMillis).ConfigureAwait(false);
+                        retryDelayMillis = Math.Min(MAX_RETRY_DELAY_MILLIS, retryDelayMillis * 2);
+                        continue;
+                    }
+
+                    retryDelayMillis = MIN_RETRY_DELAY_MILLIS;
+                    Acknowledge(record);
+                }
+            } finally {
+                lock (this) {
+                    draining = false;
+                }
+            }
+        }
+
+        /// <returns>true if the request has been delivered or refused for good</returns>
+        private async Task<bool> SendAsync(Record record, byte[] payload) {
+            HttpRequestMessage request;
+            try {
+                request = Deserialize(payload);
+                // the priority is not part of the payload, it is kept in the record header
+                RequestPriority.Set(request, record.Priority);
+            } catch (Exception e) {
+                // damaged record would block the queue forever
+                Logger.Error(TAG, $"Dropping unreadable record {record.Sequence}: {e.Message}");
+                return true;
+            }
+
+            try {
+                using (var response = await client.SendAsync(request, HttpCompletionOption.ResponseHeadersRead).ConfigureAwait(false)) {
+                    Logger.Debug(TAG, $"Record {record.Sequence} sent, status {(int)response.StatusCode}");
+                    // server errors are transient, the request is sent again later
+                    return (int)response.StatusCode < 500;
+                }
+            } catch (Exception e) {
+                Logger.Debug(TAG, $"Record {record.Sequence} not sent: {e.Message}");
+                return false;
+            }
+        }
+
+        /// <summary>
+        /// Marks the record as acknowledged and moves the head past acknowledged records
+        /// Not synced at once: after a crash the record may be sent again, which the queue allows anyway
+        /// </summary>
+        private void Acknowledge(Record record) {
+            lock (this) {
+                if (journal == null || !records.Remove(record)) return;
+                pendingBytes -= RECORD_HEADER_SIZE + record.Length;
+                WriteRecordHeader(record, STATE_ACKNOWLEDGED);
+
+                if (records.Count == 0) {
+                    // nothing pending -> the whole journal is free
+                    head = tail = HEADER_SIZE;
+                } else {
+                    head = records.Min(r => r.Offset);
+                }
+
+                WriteHeader();
+            }
+        }
+
+        /// <summary>
+        /// Reads record headers between head and tail, a record torn by a crash ends the journal
+        /// </summary>
+        private void Load() {
+            records.Clear();
+            pendingBytes = 0;
+            if (head < HEADER_SIZE || tail > capacity || head > tail) {
+                Logger.Error(TAG, "Offline queue journal is damaged, pending requests dropped");
+                head = tail = HEADER_SIZE;
+                WriteHeader();
+                return;
+            }
+
+            byte[] recordHeader = new byte[RECORD_HEADER_SIZE];
+            int offset = head;
+            while (offset + RECORD_HEADER_SIZE <= tail) {
+                journal.read(offset, recordHeader);
+                int length = BitConverter.ToInt32(recordHeader, 0);
+                if (length < 0 || offset + RECORD_HEADER_SIZE + length > tail) break;
+
+                if (recordHeader[9] == STATE_PENDING) {
+                    records.Add(new Record(offset, length, BitConverter.ToInt32(recordHeader, 4), recordHeader[8]));
+                    pendingBytes += RECORD_HEADER_SIZE + length;
+                }
+                offset += RECORD_HEADER_SIZE + length;
+            }
+
+            if (offset != tail) {
+                Logger.Error(TAG, $"Offline queue journal truncated at {offset}");
+                tail = offset;
+                WriteHeader();
+            }
+        }
+
+        /// <summary>
+        /// Writes pending records into a new journal that replaces the current one, acknowledged records are dropped
+        /// The journal is intact until the new one is complete, see Open for finishing a compaction interrupted by a crash
+        /// </summary>
+        /// <returns>false if the journal couldn't be compacted; it is closed if it couldn't be opened again</returns>
+        private bool Compact() {
+            string temporary = path + TEMPORARY_SUFFIX;
+            string compacted = path + COMPACTED_SUFFIX;
+
+            var file = new MappedFile();
+            if (file.open(temporary, capacity) != RC.RC_OK) {
+                Logger.Error(TAG, "Cannot create compacted offline queue journal");
+                return false;
+            }
+
+            var offsets = new List<int>(records.Count);
+            int offset = HEADER_SIZE;
+            bool written = true;
+            foreach (var record in records) {
+                int length = RECORD_HEADER_SIZE + record.Length;
+                byte[] data = new byte[length];
+                written &= journal.read(record.Offset, data) == RC.RC_OK && file.write(offset, data) == RC.RC_OK;
+                offsets.Add(offset);
+                offset += length;
+            }
+
+            written &= WriteHeader(file, HEADER_SIZE, offset) == RC.RC_OK && file.sync() == RC.RC_OK;
+            file.close();
+
+            // the compacted journal is complete once renamed
+            if (!written || MappedFile.rename(temporary, compacted) != RC.RC_OK) {
+                Logger.Error(TAG, "Cannot write compacted offline queue journal");
+                MappedFile.remove(temporary);
+                return false;
+            }
+
+            Logger.Debug(TAG, $"Offline queue compacted, {tail - offset} bytes released");
+            head = HEADER_SIZE;
+            tail = offset;
+            journal.close();
+            journal = null;
+            if (MappedFile.remove(path) != RC.RC_OK || MappedFile.rename(compacted, path) != RC.RC_OK) {
+                // the compaction is finished by the next Open
+                Logger.Error(TAG, "Cannot replace offline queue journal, queue disabled");
+                records.Clear();
+                pendingBytes = 0;
+                return false;
+            }
+
+            journal = new MappedFile();
+            if (journal.open(path, capacity) != RC.RC_OK) {
+                Logger.Error(TAG, "Cannot open compacted offline queue journal, queue disabled");
+                journal = null;
+                records.Clear();
+                pendingBytes = 0;
+                return false;
+            }
+
+            for (int i = 0; i < records.Count; i++) {
+                records[i].Offset = offsets[i];
+            }
+            return true;
+        }
+
+        private void WriteHeader() {
+            WriteHeader(journal, head, tail);
+        }
+
+        private int WriteHeader(MappedFile file, int head, int tail) {
+            byte[] header = new byte[HEADER_SIZE];
+            BitConverter.GetBytes(MAGIC).CopyTo(header, 0);
+            BitConverter.GetBytes(VERSION).CopyTo(header, 4);
+            BitConverter.GetBytes(capacity).CopyTo(header, 8);
+            BitConverter.GetBytes(head).CopyTo(header, 12);
+            BitConverter.GetBytes(tail).CopyTo(header, 16);
+            BitConverter.GetBytes(nextSequence).CopyTo(header, 20);
+            return file.write(0, header);
+        }
+
+        private void WriteRecordHeader(Record record, int state) {
+            byte[] recordHeader = new byte[RECORD_HEADER_SIZE];
+            BitConverter.GetBytes(record.Length).CopyTo(recordHeader, 0);
+            BitConverter.GetBytes(record.Sequence).CopyTo(recordHeader, 4);
+            recordHeader[8] = (byte)record.Priority;
+            recordHeader[9] = (byte)state;
+            journal.write(record.Offset, recordHeader);
+        }
+
+        /// <summary>
+        /// Method, uri, headers and body of the request
+        /// </summary>
+        private static async Task<byte[]> SerializeAsync(HttpRequestMessage request) {
+            byte[] body = request.Content != null ? await request.Content.ReadAsByteArrayAsync().ConfigureAwait(false) : null;
+
+            using (var stream = new MemoryStream())
+            using (var writer = new BinaryWriter(stream)) {
+                writer.Write(request.Method.Method);
+                writer.Write(request.RequestUri.ToString());
+
+                var headers = request.Headers.ToList();
+                writer.Write(headers.Count);
+                foreach (var header in headers) {
+                    writer.Write(header.Key);
+                    writer.Write(string.Join(", ", header.Value));
+                }
+
+                var contentHeaders = request.Content?.Headers.ToList() ?? new List<KeyValuePair<string, IEnumerable<string>>>();
+                writer.Write(contentHeaders.Count);
+                foreach (var header in contentHeaders) {
+                    writer.Write(header.Key);
+                    writer.Write(string.Join(", ", header.Value));
+                }
+
+                writer.Write(body != null ? body.Length : -1);
+                if (body != null) writer.Write(body);
+                writer.Flush();
+                return stream.ToArray();
+            }
+        }
+
+        private static HttpRequestMessage Deserialize(byte[] payload) {
+            using (var reader = new BinaryReader(new MemoryStream(payload))) {
+                var request = new HttpRequestMessage(new HttpMethod(reader.ReadString()), new Uri(reader.ReadString()));
+
+                int count = reader.ReadInt32();
+                for (int i = 0; i < count; i++) {
+                    request.Headers.TryAddWithoutValidation(reader.ReadString(), reader.ReadString());
+                }
+
+                var contentHeaders = new List<KeyValuePair<string, string>>();
+                count = reader.ReadInt32();
+                for (int i = 0; i < count; i++) {
+                    contentHeaders.Add(new KeyValuePair<string, string>(reader.ReadString(), reader.ReadString()));
+                }
+
+                int bodyLength = reader.ReadInt32();
+                if (bodyLength >= 0) {
+                    request.Content = new ByteArrayContent(reader.ReadBytes(bodyLength));
+                    foreach (var header in contentHeaders) {
+                        request.Content.Headers.TryAddWithoutValidation(header.Key, header.Value);
+                    }
+                }
+
+                return request;
+            }
+        }
+
+        /// <summary>
+        /// Pending record of the journal
+        /// </summary>
+        private class Record {
+            public int Offset { get; set; }
+            public int Length { get; }
+            public int Sequence { get; }
+            public int Priority { get; }
+
+            public Record(int offset, int length, int sequence, int priority) {
+                Offset = offset;
+                Length = length;
+                Sequence = sequence;
+                Priority = priority;
+            }
+        }
+    }
+}
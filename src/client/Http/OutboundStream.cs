@@ -14,12 +14,18 @@ namespace SeaCatCSharpClient.Http {
 
     /// <summary>
     /// Output stream that sends a request frames
+    /// At most MaxQueuedFrames frames wait for sending; writers await a frame credit instead of filling more frames
     /// </summary>
     public class OutboundStream : Stream, IFrameProvider {
 
+        public static int DEFAULT_MAX_QUEUED_FRAMES = 4;
+
         private Reactor reactor;
         private int streamId = -1;
-        private BlockingQueue<ByteBuffer> frameQueue = new BlockingQueue<ByteBuffer>();
+        // frames waiting for sending, guarded by the queue itself
+        private System.Collections.Generic.Queue<ByteBuffer> frameQueue = new System.Collections.Generic.Queue<ByteBuffer>();
+        // completed when a queued frame is sent (or the stream is reset); null if nobody waits
+        private TaskCompletionSource<bool> creditWaiter = null;
         private ByteBuffer currentFrame = null;
 
         private bool closed = false;
@@ -31,9 +37,20 @@ namespace SeaCatCSharpClient.Http {
         }
 
         public int WriteTimeoutMillis { get; set; } = 30 * 1000;
-        public int ContentLength { get; set; } = 0;
+        public int MaxQueuedFrames { get; set; } = DEFAULT_MAX_QUEUED_FRAMES;
+        // declared length of the body, null if the body is streamed until FIN without knowing its length
+        public long? ContentLength { get; set; } = null;
+        // number of bytes written so far
+        public long BytesWritten { get; private set; } = 0;
         public int FrameProviderPriority => priority;
 
+        /// <summary>
+        /// Changes priority of the stream, frames waiting for sending are rescheduled
+        /// </summary>
+        public void SetPriority(int priority) {
+            reactor.ChangeFrameProviderPriority(this, () => this.priority = priority);
+        }
+
         public void Launch(int streamId) {
             if (this.streamId != -1) throw new IOException("OutputStream is already launched");
             this.streamId = streamId;
@@ -46,14 +63,23 @@ namespace SeaCatCSharpClient.Http {
         public void Reset() {
             closed = true;
 
-            while (!frameQueue.IsEmpty()) {
-                ByteBuffer frame = frameQueue.Dequeue();
-                reactor.FramePool.GiveBack(frame);
+            TaskCompletionSource<bool> waiter;
+            lock (frameQueue) {
+                while (frameQueue.Count > 0) {
+                    reactor.FramePool.GiveBack(frameQueue.Dequeue());
+                }
+                waiter = creditWaiter;
+                creditWaiter = null;
             }
 
-            if (currentFrame != null) {
-                reactor.FramePool.GiveBack(currentFrame);
-                currentFrame = null;
+            // wake up the writer, it will find the stream closed
+            if (waiter != null) TaskHelper.SetResultAsync(waiter, true);
+
+            lock (this) {
+                if (currentFrame != null) {
+                    reactor.FramePool.GiveBack(currentFrame);
+                    currentFrame = null;
+                }
             }
         }
         
@@ -69,15 +95,38 @@ namespace SeaCatCSharpClient.Http {
             FlushCurrentFrame(true);
         }
 
+        /// <summary>
+        /// Reads the whole source into pooled frames and sends them, the stream is closed (FIN) at the end
+        /// Data are read directly into the frames, reading ahead at most MaxQueuedFrames frames
+        /// </summary>
+        /// <param name="source">stream with the request body (e.g. opened file)</param>
+        /// <param name="cancellationToken">cancellation token</param>
+        public async Task UploadAsync(Stream source, CancellationToken cancellationToken) {
+            while (true) {
+                if (currentFrame == null) await WaitForCreditAsync().ConfigureAwait(false);
+
+                ByteBuffer frame = GetCurrentFrame();
+                int read = await source.ReadAsync(frame.Data, frame.Position, frame.Remaining, cancellationToken).ConfigureAwait(false);
+                if (read == 0) break;
+
+                frame.Position += read;
+                BytesWritten += read;
+
+                if (frame.Remaining == 0) FlushCurrentFrame(false);
+            }
+
+            Dispose();
+        }
+
 
         public override void Flush() {
             if (currentFrame != null) FlushCurrentFrame(false);
         }
 
         public override Task FlushAsync(CancellationToken cancellationToken) {
-            var tsk = TaskHelper.CreateTask("Flush", Flush);
-            tsk.Start();
-            return tsk;
+            // flushing only queues the frame, there is nothing to wait for
+            Flush();
+            return Task.FromResult(true);
         }
 
         public override int Read(byte[] buffer, int offset, int count) {
@@ -105,33 +154,42 @@ namespace SeaCatCSharpClient.Http {
         }
 
         public override void Write(byte[] buffer, int offset, int count) {
+            WriteAsync(buffer, offset, count, CancellationToken.None).GetAwaiter().GetResult();
+        }
+
+        /// <summary>
+        /// Copies data into frames; completes synchronously unless it has to wait for a frame credit
+        /// </summary>
+        public override async Task WriteAsync(byte[] buffer, int offset, int count, CancellationToken cancellationToken) {
             if (closed) throw new IOException("OutputStream is already closed");
+            if (offset < 0 || count < 0 || offset + count > buffer.Length) throw new IndexOutOfRangeException();
 
-            ByteBuffer frame = GetCurrentFrame();
-            if (frame == null) throw new IOException("Frame not available");
-            frame.PutBytes(buffer);
-            ContentLength += count;
+            // data that don't fit into the current frame continue in the next DATA frame
+            while (count > 0) {
+                if (currentFrame == null) await WaitForCreditAsync().ConfigureAwait(false);
 
-            if (frame.Remaining == 0) FlushCurrentFrame(false);
-        }
+                ByteBuffer frame = GetCurrentFrame();
+                if (frame == null) throw new IOException("Frame not available");
 
-        public override Task WriteAsync(byte[] buffer, int offset, int count, CancellationToken cancellationToken) {
-            var tsk = TaskHelper.CreateTask<int>("Write outbound", () => {
-                Write(buffer, offset, count);
-                return count;
-            });
+                int chunk = Math.Min(count, frame.Remaining);
+                frame.PutBytes(buffer, offset, chunk);
+                BytesWritten += chunk;
+                offset += chunk;
+                count -= chunk;
 
-            tsk.Start();
-            return tsk;
+                if (frame.Remaining == 0) FlushCurrentFrame(false);
+            }
         }
 
         public override void WriteByte(byte value) {
             if (closed) throw new IOException("OutputStream is already closed");
 
+            if (currentFrame == null) WaitForCreditAsync().GetAwaiter().GetResult();
+
             ByteBuffer frame = GetCurrentFrame();
             if (frame == null) throw new IOException("Frame not available");
             frame.PutByte((byte)value);
-            ContentLength += 1;
+            BytesWritten += 1;
 
             if (frame.Remaining == 0) FlushCurrentFrame(false);
         }
@@ -164,27 +222,54 @@ namespace SeaCatCSharpClient.Http {
         }
 
         public ByteBuffer BuildFrame(Reactor reactor, out bool keep) {
-            lock (this)
-            {
-                keep = false;
+            keep = false;
+
+            Debug.Assert(streamId > 0);
 
-                Debug.Assert(streamId > 0);
+            ByteBuffer frame = null;
+            TaskCompletionSource<bool> waiter;
 
+            lock (frameQueue) {
                 // get the next frame and put id of this stream into it
-                bool success;
-                ByteBuffer frame = frameQueue.Dequeue(0, out success);
-                if (success && (frame != null))
-                {
+                if (frameQueue.Count > 0) {
+                    frame = frameQueue.Dequeue();
                     frame.PutInt(0, streamId);
-                    keep = !frameQueue.IsEmpty();
+                    keep = frameQueue.Count > 0;
 
-                    if ((frame.GetByte(4) & SPDY.FLAG_FIN) == SPDY.FLAG_FIN)
-                    {
+                    if ((frame.GetByte(4) & SPDY.FLAG_FIN) == SPDY.FLAG_FIN) {
                         // never keep FIN frame
                         Debug.Assert(!keep);
                     }
                 }
-                return frame;
+
+                // a frame has been sent -> the writer can fill another one
+                waiter = creditWaiter;
+                creditWaiter = null;
+            }
+
+            if (waiter != null) TaskHelper.SetResultAsync(waiter, true);
+            return frame;
+        }
+
+        /// <summary>
+        /// Completes when there is a space for another frame in the queue
+        /// </summary>
+        private async Task WaitForCreditAsync() {
+            while (true) {
+                Task<bool> credit;
+
+                lock (frameQueue) {
+                    if (closed || frameQueue.Count < MaxQueuedFrames) return;
+                    if (creditWaiter == null) creditWaiter = new TaskCompletionSource<bool>();
+                    credit = creditWaiter.Task;
+                }
+
+                long timeoutMillis = this.WriteTimeoutMillis;
+                if (timeoutMillis <= 0) timeoutMillis = 1000 * 60 * 3; // 3 minutes timeout
+
+                if (!await TaskHelper.WaitAsync(credit, TimeSpan.FromMilliseconds(timeoutMillis)).ConfigureAwait(false)) {
+                    throw new TimeoutException($"Write timeout: {WriteTimeoutMillis}");
+                }
             }
         }
         
@@ -216,20 +301,8 @@ namespace SeaCatCSharpClient.Http {
 
                 SPDY.BuildDataFrameFlagLength(aFrame, finFlag);
 
-                long timeoutMillis = this.WriteTimeoutMillis;
-                if (timeoutMillis == 0) timeoutMillis = 1000 * 60 * 3; // 3 minutes timeout
-                long cutOfTimeMillis = DateTimeOffset.Now.Millisecond + timeoutMillis;
-
-                bool res = false;
-
-                while (res == false) {
-
-                    long awaitMillis = cutOfTimeMillis - DateTimeOffset.Now.Millisecond;
-                    if (awaitMillis <= 0) {
-                        throw new TimeoutException($"Write timeout: {WriteTimeoutMillis}");
-                    }
-
-                    res = frameQueue.Enqueue(aFrame);
+                lock (frameQueue) {
+                    frameQueue.Enqueue(aFrame);
                 }
 
                 if (this.streamId != -1) reactor.RegisterFrameProvider(this, true);
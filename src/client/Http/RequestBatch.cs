@@ -0,0 +1,111 @@
+﻿using System;
+using System.Collections.Generic;
+using System.Linq;
+using System.Net.Http;
+using System.Runtime.CompilerServices;
+using System.Threading;
+using System.Threading.Tasks;
+using SeaCatCSharpClient.Core;
+using SeaCatCSharpClient.Interfaces;
+using SeaCatCSharpClient.Utils;
+
+namespace SeaCatCSharpClient.Http {
+
+    /// <summary>
+    /// Batch of requests sent through a single frame provider
+    /// SYN_STREAMs of all requests are written back to back into shared frames, so that the batch costs
+    /// one provider registration, one wakeup of the core and one response timer per distinct timeout instead of one per request
+    /// Awaiting the batch itself waits for all the responses
+    /// </summary>
+    public class RequestBatch : IFrameProvider {
+
+        private Reactor reactor;
+        private int priority;
+        // senders waiting for their SYN_STREAM, guarded by the queue itself
+        private System.Collections.Generic.Queue<HttpSender> pending = new System.Collections.Generic.Queue<HttpSender>();
+        private List<HttpSender> senders = new List<HttpSender>();
+        private List<Task<HttpResponseMessage>> responses = new List<Task<HttpResponseMessage>>();
+        // cancels the batch response timers once all responses arrive
+        private CancellationTokenSource responseTimeout = new CancellationTokenSource();
+
+        /// <summary>
+        /// Response of each request, in the order of the requests
+        /// </summary>
+        public IReadOnlyList<Task<HttpResponseMessage>> Responses => responses;
+
+        /// <summary>
+        /// Completed when all responses arrive (fails if any of them does)
+        /// </summary>
+        public Task<HttpResponseMessage[]> Completion { get; private set; }
+
+        public int FrameProviderPriority => RequestPriority.ToProviderPriority(priority, false);
+
+        internal RequestBatch(Reactor reactor, int priority) {
+            this.reactor = reactor;
+            this.priority = RequestPriority.Clamp(priority);
+        }
+
+        /// <summary>
+        /// Prepares the request for sending in this batch
+        /// </summary>
+        internal void Add(HttpSender sender, HttpRequestMessage request, CancellationToken cancellationToken) {
+            Task<HttpResponseMessage> response = sender.Prepare(request, cancellationToken);
+            responses.Add(response);
+            senders.Add(sender);
+
+            // cancelled already, nothing to send
+            if (!response.IsCompleted) pending.Enqueue(sender);
+        }
+
+        /// <summary>
+        /// Registers the batch as a single frame provider for all the requests added
+        /// </summary>
+        internal void Send() {
+            Completion = Task.WhenAll(responses);
+            Logger.Debug(SeaCatInternals.HTTPTAG, $"Sending batch of {responses.Count} requests");
+
+            if (pending.Count == 0) return;
+            reactor.RegisterFrameProvider(this, true);
+
+            // fail the responses that don't arrive in time; requests of the same timeout share a timer
+            foreach (var group in senders.GroupBy(sender => sender.GetResponseTimeoutMillis())) {
+                var timedOut = group.ToList();
+                Task.Delay(group.Key, responseTimeout.Token).ContinueWith(t => {
+                    if (t.IsCanceled) return;
+                    foreach (var sender in timedOut) sender.ResponseTimedOut();
+                }, TaskContinuationOptions.ExecuteSynchronously);
+            }
+            Completion.ContinueWith(t => responseTimeout.Cancel(), TaskContinuationOptions.ExecuteSynchronously);
+        }
+
+        /// <summary>
+        /// Builds SYN_STREAMs of pending requests back to back until a frame is filled up
+        /// The batch stays in the provider queue while there are requests left, so that other providers can interleave
+        /// </summary>
+        public ByteBuffer BuildFrame(Reactor reactor, out bool keep) {
+            FrameChain chain = new FrameChain(reactor.FramePool, "RequestBatch.BuildFrame");
+            int count = 0;
+
+            lock (pending) {
+                // the frame that overflows into the next one is the last of this turn
+                while (pending.Count > 0 && chain.Count == 1) {
+                    if (pending.Dequeue().AppendSynStream(chain)) count++;
+                }
+                keep = pending.Count > 0;
+            }
+
+            if (count == 0) {
+                // all remaining requests have been cancelled
+                chain.GiveBack();
+                return null;
+            }
+
+            Logger.Debug(SeaCatInternals.HTTPTAG, $"Batch: {count} SYN_STREAMs in {chain.Position} bytes");
+            return reactor.EmitChain(chain);
+        }
+
+        public TaskAwaiter<HttpResponseMessage[]> GetAwaiter() {
+            return Completion.GetAwaiter();
+        }
+    }
+}
@@ -0,0 +1,389 @@
+﻿using System;
+using System.Collections.Generic;
+using System.IO;
+using System.Linq;
+using System.Net.Http;
+using System.Text;
+using System.Threading;
+using System.Threading.Tasks;
+using SeaCatCSharpClient.Core;
+using SeaCatCSharpClient.Utils;
+
+namespace SeaCatCSharpClient.Http {
+
+    /// <summary>
+    /// Joins identical GET requests that are in flight at the same time
+    /// Only the first one is sent, its response body is read once into chunks and fanned out to all waiters,
+    /// each of them reading through its own cursor
+    /// Chunks are plain arrays rather than pooled frames: a waiter that never reads or disposes its response
+    /// must not hold frames the reactor needs for receiving
+    /// </summary>
+    public class RequestCoalescer {
+        private static string TAG = "RequestCoalescer";
+
+        private const int CHUNK_SIZE = 16 * 1024;
+
+        private Dictionary<string, InFlight> inFlight = new Dictionary<string, InFlight>();
+
+        /// <summary>
+        /// Number of requests that have been answered by a response of another one
+        /// </summary>
+        public int CoalescedCount { get; private set; }
+
+        /// <summary>
+        /// Returns the key identical requests share or null if the request can't be coalesced
+        /// The key consists of the method, uri and all request headers, so it covers any header the response may vary on
+        /// </summary>
+        public static string GetKey(HttpRequestMessage request) {
+            if (request.Method != HttpMethod.Get || request.Content != null) return null;
+
+            var key = new StringBuilder();
+            key.Append(request.Method.Method).Append(' ').Append(request.RequestUri.AbsoluteUri);
+            foreach (var header in request.Headers.OrderBy(header => header.Key, StringComparer.OrdinalIgnoreCase)) {
+                key.Append('\n').Append(header.Key.ToLower()).Append(':').Append(string.Join(",", header.Value));
+            }
+            return key.ToString();
+        }
+
+        /// <summary>
+        /// Sends the request or joins an identical one that is already in flight
+        /// The shared request is cancelled once all its waiters are cancelled
+        /// </summary>
+        /// <param name="send">sends the request if there is no identical one in flight</param>
+        public Task<HttpResponseMessage> SendAsync(HttpRequestMessage request, CancellationToken cancellationToken,
+            Func<HttpRequestMessage, CancellationToken, Task<HttpResponseMessage>> send) {
+            string key = GetKey(request);
+            // a request of its own is cancelled by its own token
+            if (key == null) return send(request, cancellationToken);
+
+            return SendCoalescedAsync(key, request, cancellationToken, send);
+        }
+
+        private async Task<HttpResponseMessage> SendCoalescedAsync(string key, HttpRequestMessage request, CancellationToken cancellationToken,
+            Func<HttpRequestMessage, CancellationToken, Task<HttpResponseMessage>> send) {
+            InFlight flight;
+            bool leader = false;
+            lock (inFlight) {
+                if (!inFlight.TryGetValue(key, out flight)) {
+                    flight = new InFlight();
+                    inFlight.Add(key, flight);
+                    leader = true;
+                } else {
+                    CoalescedCount++;
+                }
+                flight.Waiters++;
+            }
+
+            if (leader) {
+                // the shared request is not bound to cancellation of any single waiter; errors go to all waiters
+                flight.Runner = RunAsync(key, flight, request, send);
+            } else {
+                Logger.Debug(TAG, $"Joining request in flight: {request.RequestUri}");
+            }
+
+            var responseTask = flight.Response.Task;
+            if (cancellationToken.CanBeCanceled) {
+                var cancelled = new TaskCompletionSource<bool>();
+                using (cancellationToken.Register(() => cancelled.TrySetResult(true))) {
+                    if (await Task.WhenAny(responseTask, cancelled.Task).ConfigureAwait(false) != responseTask) {
+                        if (Leave(key, flight)) {
+                            // the response already counts with this waiter, its cursor must be released,
+                            // otherwise the chunks would be kept until the last reader is done
+                            Task release = responseTask.ContinueWith(task => task.Result.CreateResponse(request).Dispose(),
+                                TaskContinuationOptions.OnlyOnRanToCompletion);
+                        }
+                        throw new OperationCanceledException(cancellationToken);
+                    }
+                }
+            }
+
+            SharedResponse shared = await responseTask.ConfigureAwait(false);
+            return shared.CreateResponse(request);
+        }
+
+        /// <summary>
+        /// Removes a cancelled waiter from the flight, the shared request is cancelled when the last waiter leaves
+        /// </summary>
+        /// <returns>true if the response has arrived already and counts with the waiter</returns>
+        private bool Leave(string key, InFlight flight) {
+            lock (inFlight) {
+                if (flight.Responded) return true;
+                if (--flight.Waiters > 0) return false;
+
+                // identical requests sent from now on must not join the cancelled one
+                Remove(key, flight);
+            }
+
+            Logger.Debug(TAG, "All waiters cancelled, cancelling shared request");
+            flight.Cancellation.Cancel();
+            return false;
+        }
+
+        private void Remove(string key, InFlight flight) {
+            InFlight current;
+            if (inFlight.TryGetValue(key, out current) && current == flight) inFlight.Remove(key);
+        }
+
+        private async Task RunAsync(string key, InFlight flight, HttpRequestMessage request,
+            Func<HttpRequestMessage, CancellationToken, Task<HttpResponseMessage>> send) {
+            HttpResponseMessage response = null;
+            try {
+                response = await send(request, flight.Cancellation.Token).ConfigureAwait(false);
+
+                // no more waiters can join or leave from now on
+                int waiters;
+                lock (inFlight) {
+                    Remove(key, flight);
+                    flight.Responded = true;
+                    waiters = flight.Waiters;
+                }
+
+                if (waiters == 0) {
+                    // all waiters left while the response was arriving
+                    response.Dispose();
+                    TaskHelper.SetCanceledAsync(flight.Response);
+                    return;
+                }
+
+                // a response without other waiters is passed as it is
+                Stream body = null;
+                if (waiters > 1 && response.Content != null) body = await response.Content.ReadAsStreamAsync().ConfigureAwait(false);
+                TaskHelper.SetResultAsync(flight.Response, new SharedResponse(response, body, waiters));
+            } catch (Exception e) {
+                lock (inFlight) {
+                    Remove(key, flight);
+                    flight.Responded = true;
+                }
+                response?.Dispose();
+                TaskHelper.SetExceptionAsync(flight.Response, e);
+            }
+        }
+
+        private class InFlight {
+            // waiters that haven't been cancelled; guarded by the inFlight lock as well as Responded
+            public int Waiters;
+            // the response (or error) arrived, the number of waiters is final
+            public bool Responded;
+            // cancels the shared request once there are no waiters left
+            public CancellationTokenSource Cancellation = new CancellationTokenSource();
+            public TaskCompletionSource<SharedResponse> Response = new TaskCompletionSource<SharedResponse>();
+            // sends the shared request, never faults (errors complete Response)
+            public Task Runner;
+        }
+
+        /// <summary>
+        /// Response of the shared request
+        /// The body is read from the source on demand of the fastest cursor, a chunk is dropped once all cursors passed it
+        /// </summary>
+        private class SharedResponse {
+            private HttpResponseMessage response;
+            private Stream source;
+            // cursors that have not been created yet, chunks can't be dropped before all of them exist
+            private int unopenedCursors;
+            private List<Cursor> cursors = new List<Cursor>();
+            // chunks with the body, starting at bodyOffset
+            private List<Chunk> chunks = new List<Chunk>();
+            private long bodyOffset = 0;
+            private long bodyLength = 0;
+            private bool ended = false;
+            // only one cursor reads the source at a time
+            private SemaphoreSlim sourceLock = new SemaphoreSlim(1, 1);
+
+            public SharedResponse(HttpResponseMessage response, Stream source, int waiters) {
+                this.response = response;
+                this.source = source;
+                this.unopenedCursors = waiters;
+                this.ended = source == null;
+            }
+
+            /// <summary>
+            /// Creates a response for one of the waiters, with its own body cursor
+            /// </summary>
+            public HttpResponseMessage CreateResponse(HttpRequestMessage request) {
+                lock (this) {
+                    // called by the waiters as well as for cancelled ones
+                    if (unopenedCursors == 1 && source == null) {
+                        unopenedCursors--;
+                        return response;
+                    }
+                }
+
+                var copy = new HttpResponseMessage(response.StatusCode);
+                copy.ReasonPhrase = response.ReasonPhrase;
+                copy.Version = response.Version;
+                copy.RequestMessage = request;
+
+                foreach (var header in response.Headers) {
+                    copy.Headers.TryAddWithoutValidation(header.Key, header.Value);
+                }
+
+                if (response.Content != null) {
+                    var cursor = new Cursor(this);
+                    lock (this) {
+                        unopenedCursors--;
+                        cursors.Add(cursor);
+                    }
+
+                    copy.Content = new StreamContent(cursor);
+                    foreach (var header in response.Content.Headers) {
+                        copy.Content.Headers.TryAddWithoutValidation(header.Key, header.Value);
+                    }
+                }
+
+                return copy;
+            }
+
+            public async Task<int> ReadAsync(Cursor cursor, byte[] buffer, int offset, int count) {
+                while (true) {
+                    int read = ReadFrames(cursor, buffer, offset, count);
+                    if (read > 0 || count == 0) return read;
+
+                    await sourceLock.WaitAsync().ConfigureAwait(false);
+                    try {
+                        lock (this) {
+                            // another cursor may have read the data meanwhile
+                            if (cursor.Position < bodyLength) continue;
+                            if (ended) return 0;
+                        }
+
+                        byte[] data = new byte[CHUNK_SIZE];
+                        int received = await source.ReadAsync(data, 0, data.Length).ConfigureAwait(false);
+
+                        lock (this) {
+                            if (received == 0) {
+                                ended = true;
+                            } else {
+                                chunks.Add(new Chunk(data, received));
+                                bodyLength += received;
+                            }
+                        }
+                    } finally {
+                        sourceLock.Release();
+                    }
+                }
+            }
+
+            /// <summary>
+            /// Copies already received data at the position of the cursor
+            /// </summary>
+            private int ReadFrames(Cursor cursor, byte[] buffer, int offset, int count) {
+                int read = 0;
+
+                lock (this) {
+                    long chunkStart = bodyOffset;
+                    foreach (var chunk in chunks) {
+                        if (read == count) break;
+                        long chunkEnd = chunkStart + chunk.Length;
+                        if (cursor.Position < chunkEnd) {
+                            int chunkOffset = (int)(cursor.Position - chunkStart);
+                            int copied = Math.Min(count - read, chunk.Length - chunkOffset);
+                            Buffer.BlockCopy(chunk.Data, chunkOffset, buffer, offset + read, copied);
+                            read += copied;
+                            cursor.Position += copied;
+                        }
+                        chunkStart = chunkEnd;
+                    }
+
+                    ReleaseChunks();
+                }
+
+                return read;
+            }
+
+            public void Close(Cursor cursor) {
+                bool last;
+                lock (this) {
+                    if (!cursors.Remove(cursor)) return;
+                    last = cursors.Count == 0 && unopenedCursors == 0;
+                    ReleaseChunks();
+                }
+
+                if (last) {
+                    // nobody reads the body anymore
+                    response.Dispose();
+                }
+            }
+
+            /// <summary>
+            /// Drops chunks that have been passed by all cursors
+            /// </summary>
+            private void ReleaseChunks() {
+                if (unopenedCursors > 0) return;
+                long slowest = cursors.Count > 0 ? cursors.Min(c => c.Position) : long.MaxValue;
+
+                while (chunks.Count > 0 && bodyOffset + chunks[0].Length <= slowest) {
+                    bodyOffset += chunks[0].Length;
+                    chunks.RemoveAt(0);
+                }
+            }
+        }
+
+        private class Chunk {
+            public byte[] Data { get; }
+            public int Length { get; }
+
+            public Chunk(byte[] data, int length) {
+                Data = data;
+                Length = length;
+            }
+        }
+
+        /// <summary>
+        /// Read cursor of one waiter over the shared body
+        /// </summary>
+        private class Cursor : Stream {
+            private SharedResponse shared;
+            private bool closed = false;
+
+            public Cursor(SharedResponse shared) {
+                this.shared = shared;
+            }
+
+            public override long Position { get; set; }
+
+            public override int Read(byte[] buffer, int offset, int count) {
+                return ReadAsync(buffer, offset, count, CancellationToken.None).GetAwaiter().GetResult();
+            }
+
+            public override Task<int> ReadAsync(byte[] buffer, int offset, int count, CancellationToken cancellationToken) {
+                if (offset < 0 || count < 0 || offset + count > buffer.Length) throw new IndexOutOfRangeException();
+                if (closed) throw new ObjectDisposedException(nameof(Cursor));
+                return shared.ReadAsync(this, buffer, offset, count);
+            }
+
+            protected override void Dispose(bool disposing) {
+                if (disposing && !closed) {
+                    closed = true;
+                    shared.Close(this);
+                }
+                base.Dispose(disposing);
+            }
+
+            public override void Flush() {
+                // nothing to do here
+            }
+
+            public override long Seek(long offset, SeekOrigin origin) {
+                throw new NotImplementedException("Not implemented!");
+            }
+
+            public override void SetLength(long value) {
+                throw new NotImplementedException("Not implemented!");
+            }
+
+            public override void Write(byte[] buffer, int offset, int count) {
+                throw new NotImplementedException("Not implemented!");
+            }
+
+            public override bool CanRead => true; // this stream is read-only
+
+            public override bool CanSeek => false;
+
+            public override bool CanWrite => false;
+
+            public override long Length {
+                get { throw new NotImplementedException("Not implemented!"); }
+            }
+        }
+    }
+}
@@ -0,0 +1,61 @@
+﻿using System;
+using System.Net.Http;
+
+namespace SeaCatCSharpClient.Http {
+
+    /// <summary>
+    /// Priority of a request, 0 (highest) to 7 (lowest) as in SPDY SYN_STREAM
+    /// Set per request in HttpRequestMessage.Properties under PROPERTY, changed in flight by Set
+    /// </summary>
+    public static class RequestPriority {
+
+        public const string PROPERTY = "SeaCat.Priority";
+        // sender of the request in flight, used for reprioritization; removed once the request ends
+        internal const string SENDER = "SeaCat.Sender";
+
+        public const int HIGHEST = 0;
+        public const int FOREGROUND = 2;
+        public const int DEFAULT = 3;
+        public const int BACKGROUND = 6;
+        public const int LOWEST = 7;
+
+        // reactor frame provider priorities below this one are reserved for control frames (ping, RST_STREAM)
+        private const int PROVIDER_PRIORITY_BASE = 2;
+
+        /// <summary>
+        /// Returns the priority set in request properties or the default one
+        /// </summary>
+        public static int Get(HttpRequestMessage request, int defaultPriority) {
+            object value;
+            if (request.Properties.TryGetValue(PROPERTY, out value) && value is int) return Clamp((int)value);
+            return Clamp(defaultPriority);
+        }
+
+        /// <summary>
+        /// Sets priority of the request; if the request is already in flight, its frames waiting for sending are rescheduled
+        /// </summary>
+        public static void Set(HttpRequestMessage request, int priority) {
+            priority = Clamp(priority);
+            object sender;
+
+            lock (request.Properties) {
+                request.Properties[PROPERTY] = priority;
+                request.Properties.TryGetValue(SENDER, out sender);
+            }
+
+            (sender as HttpSender)?.SetPriority(priority);
+        }
+
+        /// <summary>
+        /// Maps request priority to the priority of the reactor frame provider
+        /// Body frames of a request in flight go ahead of new requests of the same priority
+        /// </summary>
+        public static int ToProviderPriority(int priority, bool body) {
+            return PROVIDER_PRIORITY_BASE + (Clamp(priority) << 1) + (body ? 0 : 1);
+        }
+
+        public static int Clamp(int priority) {
+            return Math.Max(HIGHEST, Math.Min(LOWEST, priority));
+        }
+    }
+}
@@ -0,0 +1,69 @@
+﻿using System;
+
+namespace SeaCatCSharpClient.Http {
+
+    /// <summary>
+    /// Timestamps of a single request on the seacatcc_time clock (seconds), NaN until the event happens
+    /// The instance is stored in request properties under PROPERTY and filled in as the response arrives
+    /// </summary>
+    public class RequestTimings {
+
+        /// <summary>
+        /// Key of the timings in HttpRequestMessage.Properties (also reachable through HttpResponseMessage.RequestMessage)
+        /// </summary>
+        public const string PROPERTY = "SeaCat.Timings";
+
+        /// <summary>
+        /// Request has been queued for sending
+        /// </summary>
+        public double Enqueued { get; internal set; } = double.NaN;
+
+        /// <summary>
+        /// SYN_STREAM has been handed to the core
+        /// </summary>
+        public double SynSent { get; internal set; } = double.NaN;
+
+        /// <summary>
+        /// SYN_REPLY has been received
+        /// </summary>
+        public double ReplyReceived { get; internal set; } = double.NaN;
+
+        /// <summary>
+        /// First DATA frame has been received
+        /// </summary>
+        public double FirstData { get; internal set; } = double.NaN;
+
+        /// <summary>
+        /// Last frame of the response (FIN) has been received
+        /// </summary>
+        public double Finished { get; internal set; } = double.NaN;
+
+        /// <summary>
+        /// Number of times the request has been sent again after a reset of the gateway connection
+        /// </summary>
+        public int Replays { get; internal set; } = 0;
+
+        /// <summary>
+        /// Time spent in the frame provider queue in milliseconds
+        /// </summary>
+        public double QueueMillis => Millis(Enqueued, SynSent);
+
+        /// <summary>
+        /// Time spent waiting for the gateway (and the server behind it) in milliseconds
+        /// </summary>
+        public double GatewayMillis => Millis(SynSent, ReplyReceived);
+
+        /// <summary>
+        /// Time of the body transfer in milliseconds
+        /// </summary>
+        public double TransferMillis => Millis(ReplyReceived, Finished);
+
+        public double TotalMillis => Millis(Enqueued, Finished);
+
+        private static double Millis(double from, double to) => (to - from) * 1000.0;
+
+        public override string ToString() {
+            return $"[RequestTimings queue={QueueMillis:F1}ms gateway={GatewayMillis:F1}ms transfer={TransferMillis:F1}ms total={TotalMillis:F1}ms replays={Replays}]";
+        }
+    }
+}
@@ -0,0 +1,34 @@
+﻿using System;
+using System.Net.Http;
+
+namespace SeaCatCSharpClient.Http {
+
+    /// <summary>
+    /// Decides which requests are sent again when the gateway connection is reset before their response arrives
+    /// Only idempotent requests with no body or with a small in-memory body can be replayed
+    /// </summary>
+    public class RetryPolicy {
+
+        /// <summary>
+        /// Maximum number of replays of a single request
+        /// </summary>
+        public int MaxReplays { get; set; } = 2;
+
+        /// <summary>
+        /// Returns true if the request may be sent again
+        /// </summary>
+        /// <param name="request">request lost with the gateway connection</param>
+        /// <param name="replays">number of replays so far</param>
+        public virtual bool IsReplayable(HttpRequestMessage request, int replays) {
+            return replays < MaxReplays && IsIdempotent(request.Method);
+        }
+
+        /// <summary>
+        /// Methods that can be repeated without changing the result (RFC 7231, 4.2.2)
+        /// </summary>
+        public static bool IsIdempotent(HttpMethod method) {
+            return method == HttpMethod.Get || method == HttpMethod.Head || method == HttpMethod.Options
+                || method == HttpMethod.Put || method == HttpMethod.Delete || method == HttpMethod.Trace;
+        }
+    }
+}
@@ -0,0 +1,99 @@
+﻿using System;
+using System.Net.Http;
+using System.Threading;
+using System.Threading.Tasks;
+using SeaCatCSharpClient.Core;
+using SeaCatCSharpClient.Utils;
+
+namespace SeaCatCSharpClient.Http {
+
+    /// <summary>
+    /// Long-lived stream that pushes messages from the server
+    /// Each message is preceded by its length (32-bit, big endian), see MessageReader
+    /// The request is sent again when the gateway connection is reset, the subscription ends when the server sends FIN
+    /// </summary>
+    public class Subscription : IDisposable {
+
+        private System.Net.Http.HttpClient client;
+        private Reactor reactor;
+        private HttpRequestMessage request;
+        private int priority;
+        private MessageReader reader;
+        private CancellationTokenSource cancellation = new CancellationTokenSource();
+        private int resubscriptions = 0;
+
+        internal Subscription(System.Net.Http.HttpClient client, Reactor reactor, HttpRequestMessage request, int priority, Action<byte[]> messageReceived) {
+            this.client = client;
+            this.reactor = reactor;
+            this.request = request;
+            this.priority = priority;
+            this.reader = new MessageReader(messageReceived);
+        }
+
+        /// <summary>
+        /// Completed when the server closes the stream, failed on an error, cancelled by Dispose
+        /// </summary>
+        public Task Completion => reader.Completion;
+
+        /// <summary>
+        /// Number of times the request has been sent again after a reset of the gateway connection
+        /// </summary>
+        public int Resubscriptions => Volatile.Read(ref resubscriptions);
+
+        internal void Start() {
+            Task.Run(RunAsync);
+        }
+
+        /// <summary>
+        /// Returns the next message; used when no callback has been given
+        /// </summary>
+        /// <returns>the message or null once the subscription has ended</returns>
+        public Task<byte[]> ReceiveAsync() {
+            return reader.ReceiveAsync();
+        }
+
+        public void Dispose() {
+            cancellation.Cancel();
+            reader.Finish(null, true);
+        }
+
+        private async Task RunAsync() {
+            while (!cancellation.IsCancellationRequested) {
+                int generation = reactor.GatewayGeneration;
+                var sender = new HttpSender(client, reactor, priority) { RecordTimings = false };
+
+                try {
+                    HttpResponseMessage response = await sender.SendAsync(request, cancellation.Token).ConfigureAwait(false);
+
+                    if (reactor.GatewayGeneration == generation) {
+                        if (!response.IsSuccessStatusCode) {
+                            throw new HttpRequestException($"Subscription to {request.RequestUri} failed: {(int)response.StatusCode}");
+                        }
+
+                        // messages may be any time apart
+                        sender.InboundStream.ReadTimeoutMillis = Timeout.Infinite;
+                        // fails if the stream is reset (RST_STREAM from the server) rather than closed by FIN
+                        await reader.ReadAsync(sender.InboundStream).ConfigureAwait(false);
+                    }
+                } catch (Exception e) {
+                    if (cancellation.IsCancellationRequested) return;
+                    if (reactor.GatewayGeneration == generation) {
+                        Logger.Error(SeaCatInternals.HTTPTAG, $"Subscription to {request.RequestUri} failed: {e.Message}");
+                        reader.Finish(e, false);
+                        return;
+                    }
+                }
+
+                if (reactor.GatewayGeneration == generation) {
+                    // the server closed the stream by FIN
+                    reader.Finish(null, false);
+                    return;
+                }
+
+                // the stream has been lost with the gateway connection
+                Interlocked.Increment(ref resubscriptions);
+                Logger.Debug(SeaCatInternals.HTTPTAG, $"Subscription to {request.RequestUri} lost by gateway reset, subscribing again");
+            }
+        }
+    }
+}
@@ -0,0 +1,56 @@
+﻿using System;
+using System.Threading;
+using SeaCatCSharpClient.Utils;
+
+namespace SeaCatCSharpClient.Http {
+
+    /// <summary>
+    /// Aggregated timings of completed requests, one histogram per phase
+    /// </summary>
+    public class TimingStatistics {
+
+        public Histogram Queue { get; } = new Histogram("queue");
+        public Histogram Gateway { get; } = new Histogram("gateway");
+        public Histogram Transfer { get; } = new Histogram("transfer");
+        public Histogram Total { get; } = new Histogram("total");
+
+        private long replays = 0;
+
+        /// <summary>
+        /// Number of requests sent again after a reset of the gateway connection
+        /// </summary>
+        public long Replays => Interlocked.Read(ref replays);
+
+        public void RecordReplay() {
+            Interlocked.Increment(ref replays);
+        }
+
+        /// <summary>
+        /// Records timings of a request whose response has been completely received
+        /// </summary>
+        public void Record(RequestTimings timings) {
+            Record(Queue, timings.QueueMillis);
+            Record(Gateway, timings.GatewayMillis);
+            Record(Transfer, timings.TransferMillis);
+            Record(Total, timings.TotalMillis);
+        }
+
+        private static void Record(Histogram histogram, double millis) {
+            // phases that haven't been timed are skipped
+            if (double.IsNaN(millis)) return;
+            histogram.Record(millis);
+        }
+
+        public void Clear() {
+            Queue.Clear();
+            Gateway.Clear();
+            Transfer.Clear();
+            Total.Clear();
+            Interlocked.Exchange(ref replays, 0);
+        }
+
+        public override string ToString() {
+            return $"[TimingStatistics {Queue} {Gateway} {Transfer} {Total} replays={Replays}]";
+        }
+    }
+}
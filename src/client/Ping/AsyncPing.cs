@@ -0,0 +1,30 @@
+﻿using System;
+using System.Threading.Tasks;
+using SeaCatCSharpClient.Utils;
+
+namespace SeaCatCSharpClient.Ping {
+
+    /// <summary>
+    /// Ping whose round trip can be awaited
+    /// </summary>
+    public class AsyncPing : Ping {
+
+        private TaskCompletionSource<TimeSpan> completion = new TaskCompletionSource<TimeSpan>();
+
+        /// <summary>
+        /// Completed with the round-trip time when pong arrives, cancelled if the ping expires or the connection is reset
+        /// </summary>
+        public Task<TimeSpan> Completion => completion.Task;
+
+        public override void Pong() {
+            base.Pong();
+            // never continue the awaiting code on the reactor thread
+            TaskHelper.SetResultAsync(completion, Rtt);
+        }
+
+        public override void Cancel() {
+            base.Cancel();
+            TaskHelper.SetCanceledAsync(completion);
+        }
+    }
+}
@@ -0,0 +1,184 @@
+﻿using System;
+using System.Threading;
+using System.Threading.Tasks;
+using SeaCatCSharpClient.Utils;
+
+namespace SeaCatCSharpClient.Ping {
+
+    /// <summary>
+    /// Keeps an idle gateway connection alive with as few radio wake-ups as possible
+    /// Pings only after IdleInterval without any traffic, sends the ping together with other outbound traffic
+    /// once the idle period is nearly over and adapts the interval to the NAT timeouts observed on the link
+    /// All times are seconds of the seacatcc_time clock passed in by the caller, so that the scheduler can run on a simulated clock
+    /// </summary>
+    public class KeepaliveScheduler {
+
+        private static string TAG = "Keepalive";
+
+        public static double MIN_INTERVAL = 15.0;
+        public static double MAX_INTERVAL = 10 * 60.0;
+        // outbound traffic after this fraction of the interval carries the ping with it
+        public static double PIGGYBACK_FRACTION = 0.75;
+        // interval relative to the shortest NAT timeout observed
+        public static double NAT_MARGIN = 0.8;
+        // a shortened interval grows by GROWTH after this many successful keepalives in a row
+        public static int SUCCESSES_TO_GROW = 5;
+        public static double GROWTH = 1.25;
+
+        private Func<Task<TimeSpan>> sendPing;
+        private double idleInterval = 2 * 60.0;
+
+        // set by the reactor for every frame, folded into timestamps on the heart beat
+        private int frameSent = 0;
+        private int frameReceived = 0;
+        // the ping should go out with the next outbound frame
+        private volatile bool piggybackDue = false;
+
+        private bool connected = false;
+        private bool pingInFlight = false;
+        private double lastSent;
+        private double lastReceived;
+        private int successes = 0;
+
+        /// <param name="sendPing">sends a ping, the task completes when pong arrives</param>
+        public KeepaliveScheduler(Func<Task<TimeSpan>> sendPing) {
+            this.sendPing = sendPing;
+            Interval = idleInterval;
+        }
+
+        public bool Enabled { get; set; } = true;
+
+        /// <summary>
+        /// Configured idle period (seconds) after which the connection is pinged; resets the adapted interval
+        /// </summary>
+        public double IdleInterval {
+            get { return idleInterval; }
+            set {
+                lock (this) {
+                    idleInterval = Math.Max(MIN_INTERVAL, Math.Min(MAX_INTERVAL, value));
+                    Interval = Math.Min(idleInterval, NatTimeout * NAT_MARGIN);
+                    successes = 0;
+                }
+            }
+        }
+
+        /// <summary>
+        /// Current idle period (seconds) after which the connection is pinged
+        /// </summary>
+        public double Interval { get; private set; }
+
+        /// <summary>
+        /// Shortest idle period (seconds) after which the connection has been lost, infinity if none has been observed
+        /// </summary>
+        public double NatTimeout { get; private set; } = double.PositiveInfinity;
+
+        /// <summary>
+        /// Called by the reactor for every frame sent; sends the ping along if it is due soon
+        /// </summary>
+        public void FrameSent() {
+            Volatile.Write(ref frameSent, 1);
+            if (piggybackDue) SendPing("piggyback");
+        }
+
+        /// <summary>
+        /// Called by the reactor for every frame received
+        /// </summary>
+        public void FrameReceived() {
+            Volatile.Write(ref frameReceived, 1);
+        }
+
+        public void Connected(double now) {
+            lock (this) {
+                connected = true;
+                pingInFlight = false;
+                lastSent = lastReceived = now;
+                Volatile.Write(ref frameSent, 0);
+                Volatile.Write(ref frameReceived, 0);
+            }
+        }
+
+        /// <summary>
+        /// Called when the gateway connection is reset; a reset after a long silence of the gateway is taken as a NAT timeout
+        /// </summary>
+        public void Reset(double now) {
+            lock (this) {
+                Fold(now);
+                if (!connected) return;
+                connected = false;
+                piggybackDue = false;
+
+                double silence = now - lastReceived;
+                if (Enabled && silence >= MIN_INTERVAL) {
+                    NatTimeout = Math.Min(NatTimeout, silence);
+                    Interval = Math.Max(MIN_INTERVAL, Math.Min(Interval, NatTimeout * NAT_MARGIN));
+                    successes = 0;
+                    Logger.Debug(TAG, $"Connection lost after {silence:F0}s of silence, keepalive interval {Interval:F0}s");
+                }
+            }
+        }
+
+        /// <summary>
+        /// Pings the connection if it has been idle for Interval
+        /// </summary>
+        /// <returns>seconds until the next heart beat is needed</returns>
+        public double HeartBeat(double now) {
+            bool ping;
+            double remaining;
+
+            lock (this) {
+                Fold(now);
+                if (!Enabled || !connected) {
+                    piggybackDue = false;
+                    return MAX_INTERVAL;
+                }
+
+                double idle = now - Math.Max(lastSent, lastReceived);
+                ping = !pingInFlight && idle >= Interval;
+                piggybackDue = !pingInFlight && idle >= Interval * PIGGYBACK_FRACTION;
+                remaining = Math.Max(0, Interval - idle);
+            }
+
+            if (ping) SendPing("idle");
+            return remaining;
+        }
+
+        /// <summary>
+        /// Turns activity flags set since the last call into timestamps
+        /// </summary>
+        private void Fold(double now) {
+            if (Interlocked.Exchange(ref frameSent, 0) == 1) lastSent = now;
+            if (Interlocked.Exchange(ref frameReceived, 0) == 1) lastReceived = now;
+        }
+
+        private void SendPing(string reason) {
+            lock (this) {
+                if (pingInFlight || !connected) return;
+                pingInFlight = true;
+                piggybackDue = false;
+            }
+
+            // the ping is traffic too, the idle period starts again
+            Volatile.Write(ref frameSent, 1);
+
+            Logger.Debug(TAG, $"Sending keepalive ping ({reason})");
+            // synchronously, so that a ping completed at once (e.g. on a simulated link) is accounted before returning
+            sendPing().ContinueWith(t => PingCompleted(t.Status == TaskStatus.RanToCompletion), TaskContinuationOptions.ExecuteSynchronously);
+        }
+
+        private void PingCompleted(bool success) {
+            lock (this) {
+                pingInFlight = false;
+                if (!success) {
+                    successes = 0;
+                    return;
+                }
+
+                // the connection survived the whole interval of silence, get back towards the configured one
+                if (++successes >= SUCCESSES_TO_GROW) {
+                    successes = 0;
+                    Interval = Math.Min(Math.Min(idleInterval, NatTimeout * NAT_MARGIN), Interval * GROWTH);
+                }
+            }
+        }
+    }
+}
@@ -22,15 +22,30 @@ namespace SeaCatCSharpClient.Ping {
 
         public int PingId { get; set; }
 
+        /// <summary>
+        /// Time (seacatcc_time) when the ping has been handed to the core, NaN until then
+        /// </summary>
+        public double SentAt { get; set; } = double.NaN;
+
+        /// <summary>
+        /// Time (seacatcc_time) when the pong arrived, NaN until then
+        /// </summary>
+        public double ReceivedAt { get; set; } = double.NaN;
+
+        /// <summary>
+        /// Measured round-trip time, zero until the pong arrives
+        /// </summary>
+        public TimeSpan Rtt => double.IsNaN(ReceivedAt - SentAt) ? TimeSpan.Zero : TimeSpan.FromSeconds(ReceivedAt - SentAt);
+
         public bool IsExpired(double now) {
             return now >= deadline;
         }
 
-        public void Pong() {
-            Logger.Info("Ping", "===== PONG =====");
+        public virtual void Pong() {
+            Logger.Info("Ping", $"===== PONG ===== {Rtt.TotalMilliseconds:F1} ms");
         }
 
-        public void Cancel() {
+        public virtual void Cancel() {
             // nothing to do here
         }
     }
@@ -4,6 +4,7 @@ using SeaCatCSharpClient.Utils;
 using System;
 using System.Collections.Generic;
 using System.Linq;
+using System.Threading.Tasks;
 
 namespace SeaCatCSharpClient.Ping {
 
@@ -17,6 +18,21 @@ namespace SeaCatCSharpClient.Ping {
         private BlockingQueue<Ping> outboundPingQueue = new BlockingQueue<Ping>();
         private Dictionary<int, Ping> waitingPingDict = new Dictionary<int, Ping>();
 
+        /// <summary>
+        /// Round-trip time of the current gateway connection, measured by pings
+        /// </summary>
+        public RttEstimator Rtt { get; } = new RttEstimator();
+
+        /// <summary>
+        /// Pings the gateway
+        /// </summary>
+        /// <returns>measured round-trip time; cancelled if the ping expires or the connection is reset</returns>
+        public Task<TimeSpan> PingAsync(Reactor reactor) {
+            var ping = new AsyncPing();
+            Ping(reactor, ping);
+            return ping.Completion;
+        }
+
         public void Ping(Reactor reactor, Ping ping) {
             lock (this) {
                 Logger.Debug(TAG, "Adding ping to the queue");
@@ -29,9 +45,11 @@ namespace SeaCatCSharpClient.Ping {
             lock (this) {
                 Logger.Debug(TAG, "Reset");
                 idSequence.Set(1);
+                // RTT belongs to the connection that is gone
+                Rtt.Reset();
 
                 // remove all waiting pings
-                foreach (var key in waitingPingDict.Keys) {
+                foreach (var key in waitingPingDict.Keys.ToList()) {
                     Ping ping = waitingPingDict[key];
                     waitingPingDict.Remove(key);
                     ping.Cancel();
@@ -83,6 +101,7 @@ namespace SeaCatCSharpClient.Ping {
                     //ping object (request to gateway)
                     ping.PingId = idSequence.GetAndAdd(2);
                     waitingPingDict.Add(ping.PingId, ping);
+                    ping.SentAt = reactor.Bridge.time();
                 }
 
                 // borrow a new frame and write data to it
@@ -102,11 +121,15 @@ namespace SeaCatCSharpClient.Ping {
 
                 if ((pingId % 2) == 1) {
                     // Pong frame received ...
-                    Ping ping = waitingPingDict[pingId];
-                    waitingPingDict.Remove(pingId);
-
-                    if (ping != null) ping.Pong();
-                    else Logger.Warning(TAG, "received pong with unknown id: " + pingId);
+                    Ping ping;
+                    if (waitingPingDict.TryGetValue(pingId, out ping)) {
+                        waitingPingDict.Remove(pingId);
+                        ping.ReceivedAt = reactor.Bridge.time();
+                        Rtt.Sample(ping.ReceivedAt - ping.SentAt);
+                        ping.Pong();
+                    } else {
+                        Logger.Warning(TAG, "received pong with unknown id: " + pingId);
+                    }
 
                 } else {
                     //Send pong back to server
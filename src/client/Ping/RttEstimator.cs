@@ -0,0 +1,106 @@
+﻿using System;
+
+namespace SeaCatCSharpClient.Ping {
+
+    /// <summary>
+    /// Smoothed round-trip time of the gateway connection estimated from pings (RFC 6298)
+    /// </summary>
+    public class RttEstimator {
+
+        // gains of the smoothed RTT and of the RTT variance
+        public static double ALPHA = 1.0 / 8;
+        public static double BETA = 1.0 / 4;
+
+        // request timeout = time for the server to respond + a multiple of the retransmission timeout
+        public static int SERVER_ALLOWANCE_MILLIS = 10 * 1000;
+        public static int RTO_MULTIPLIER = 16;
+        public static int MIN_TIMEOUT_MILLIS = 10 * 1000;
+        public static int MAX_TIMEOUT_MILLIS = 3 * 60 * 1000;
+
+        private int samples = 0;
+        private double smoothedRtt = 0;
+        private double rttVariance = 0;
+        private double lastRtt = 0;
+
+        /// <summary>
+        /// Number of RTT samples since the connection has been established
+        /// </summary>
+        public int Samples {
+            get { lock (this) return samples; }
+        }
+
+        public TimeSpan SmoothedRtt {
+            get { lock (this) return TimeSpan.FromSeconds(smoothedRtt); }
+        }
+
+        public TimeSpan RttVariance {
+            get { lock (this) return TimeSpan.FromSeconds(rttVariance); }
+        }
+
+        public TimeSpan LastRtt {
+            get { lock (this) return TimeSpan.FromSeconds(lastRtt); }
+        }
+
+        /// <summary>
+        /// Smoothed RTT plus four times its variance
+        /// </summary>
+        public TimeSpan RetransmissionTimeout {
+            get { lock (this) return TimeSpan.FromSeconds(smoothedRtt + 4 * rttVariance); }
+        }
+
+        /// <summary>
+        /// Adds a measured round trip
+        /// </summary>
+        /// <param name="rtt">round-trip time in seconds</param>
+        public void Sample(double rtt) {
+            if (rtt < 0 || double.IsNaN(rtt)) return;
+
+            lock (this) {
+                if (samples == 0) {
+                    smoothedRtt = rtt;
+                    rttVariance = rtt / 2;
+                } else {
+                    rttVariance = (1 - BETA) * rttVariance + BETA * Math.Abs(smoothedRtt - rtt);
+                    smoothedRtt = (1 - ALPHA) * smoothedRtt + ALPHA * rtt;
+                }
+
+                lastRtt = rtt;
+                samples++;
+            }
+        }
+
+        /// <summary>
+        /// Returns request timeout that fits the current link, never longer than the given one
+        /// </summary>
+        /// <param name="defaultMillis">timeout used while there is no RTT sample</param>
+        public int GetTimeoutMillis(int defaultMillis) {
+            double rto;
+            lock (this) {
+                if (samples == 0) return defaultMillis;
+                rto = smoothedRtt + 4 * rttVariance;
+            }
+
+            double timeoutMillis = SERVER_ALLOWANCE_MILLIS + RTO_MULTIPLIER * rto * 1000;
+            timeoutMillis = Math.Max(MIN_TIMEOUT_MILLIS, Math.Min(MAX_TIMEOUT_MILLIS, timeoutMillis));
+            return (int)Math.Min(defaultMillis, timeoutMillis);
+        }
+
+        /// <summary>
+        /// Forgets all samples, e.g. when the gateway connection is reset
+        /// </summary>
+        public void Reset() {
+            lock (this) {
+                samples = 0;
+                smoothedRtt = 0;
+                rttVariance = 0;
+                lastRtt = 0;
+            }
+        }
+
+        public override string ToString() {
+            lock (this) {
+                return $"[RttEstimator srtt={smoothedRtt * 1000:F1}ms rttvar={rttVariance * 1000:F1}ms samples={samples}]";
+            }
+        }
+    }
+}
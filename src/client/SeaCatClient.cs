@@ -9,6 +9,7 @@ using System.Linq;
 using System.Net;
 using System.Net.Http;
 using System.Text;
+using System.Threading;
 using System.Threading.Tasks;
 
 namespace SeaCatCSharpClient {
@@ -21,6 +22,9 @@ namespace SeaCatCSharpClient {
 
         private static Reactor reactor = null;
         private static bool initialized = false;
+        // handler shared by batches, subscriptions and channels, created on first use
+        private static SeacatHttpClientHandler sharedHandler = null;
+        private static object sharedHandlerLock = new object();
 
         /// <summary>
         /// The event category for all intents sent by SeaCat client
@@ -55,6 +59,12 @@ namespace SeaCatCSharpClient {
 
         public static String ACTION_SEACAT_CLIENTID_CHANGED = "mobi.seacat.client.event.action.CLIENTID_CHANGED";
 
+        /// <summary>
+        /// The event action used to inform that obtaining of the client identity reached a new phase.
+        /// The phase is in EXTRA_IDENTITY_PHASE.
+        /// </summary>
+        public static String ACTION_SEACAT_IDENTITY_PROGRESS = "mobi.seacat.client.event.action.IDENTITY_PROGRESS";
+
         /// <summary>
         /// The key to event extras with information about client state.<br>
         /// Used in ACTION_SEACAT_STATE_CHANGED events.
@@ -64,6 +74,7 @@ namespace SeaCatCSharpClient {
 
         public static String EXTRA_CLIENT_ID = "SEACAT_CLIENT_ID";
         public static String EXTRA_CLIENT_TAG = "SEACAT_CLIENT_TAG";
+        public static String EXTRA_IDENTITY_PHASE = "SEACAT_IDENTITY_PHASE";
 
         /// <summary>
         /// Initialize SeaCat Windows Phone client.<br/>
@@ -83,6 +94,10 @@ namespace SeaCatCSharpClient {
             SetCSRWorker(CSRworker);
 
             try {
+                // the shared handler belongs to the previous reactor
+                lock (sharedHandlerLock) {
+                    sharedHandler = null;
+                }
                 reactor = new Reactor();
                 reactor.Init(appName, appSuffix, platform, storageDir);
                 // Process plugins
@@ -122,13 +137,25 @@ namespace SeaCatCSharpClient {
             Reactor.PingFactory.Ping(reactor, new Ping.Ping() { });
         }
 
+        /// <summary>
+        /// Pings SeaCat gateway and returns the measured round-trip time.
+        ///
+        /// Each measurement also updates the RTT estimate that scales default request timeouts to the current link.
+        /// </summary>
+        public static Task<TimeSpan> PingAsync() {
+            if (!initialized) {
+                throw new Exception("Seacat is not initialized!");
+            }
+            return Reactor.PingFactory.PingAsync(reactor);
+        }
+
 
         public static HttpClient Open() {
             if (!initialized) {
                 throw new Exception("Seacat is not initialized!");
             }
 
-            var handler = new SeacatHttpClientHandler(Reactor, 3);
+            var handler = new SeacatHttpClientHandler(Reactor, RequestPriority.DEFAULT);
             var client = new HttpClient(handler);
             handler.HttpClient = client;
             return client;
@@ -140,10 +167,104 @@ namespace SeaCatCSharpClient {
             {
                 throw new Exception("Seacat is not initialized!");
             }
-            var handler = new SeacatHttpClientHandler(Reactor, 3);
+            var handler = new SeacatHttpClientHandler(Reactor, RequestPriority.DEFAULT);
             return handler;
         }
 
+        /// <summary>
+        /// Sends many requests at once with a minimal per-request overhead.
+        ///
+        /// SYN_STREAMs of all requests are written back to back by a single frame provider.
+        /// Each response is available in RequestBatch.Responses; awaiting the batch waits for all of them.
+        /// </summary>
+        public static RequestBatch SendBatch(IEnumerable<HttpRequestMessage> requests, CancellationToken cancellationToken = default(CancellationToken)) {
+            return GetSharedHandler().SendBatch(requests, cancellationToken);
+        }
+
+        /// <summary>
+        /// Subscribes to a server stream of length-delimited messages instead of polling.
+        ///
+        /// The stream survives resets of the gateway connection (the request is sent again) and ends when the server closes it.
+        /// Messages are passed to the callback or, without it, read by Subscription.ReceiveAsync.
+        /// </summary>
+        public static Subscription Subscribe(HttpRequestMessage request, Action<byte[]> messageReceived = null) {
+            return GetSharedHandler().Subscribe(request, messageReceived);
+        }
+
+        /// <summary>
+        /// Opens a full-duplex channel: both sides exchange length-delimited messages over a single stream.
+        ///
+        /// Only the opening request carries HTTP headers. Messages from the server are passed to the callback
+        /// or, without it, read by Channel.ReceiveAsync.
+        /// </summary>
+        public static Task<Channel> OpenChannelAsync(HttpRequestMessage request, Action<byte[]> messageReceived = null, CancellationToken cancellationToken = default(CancellationToken)) {
+            return GetSharedHandler().OpenChannelAsync(request, messageReceived, cancellationToken);
+        }
+
+        /// <summary>
+        /// Returns the handler (with its http client) shared by all batches, subscriptions and channels of the current reactor
+        /// </summary>
+        private static SeacatHttpClientHandler GetSharedHandler() {
+            if (!initialized) {
+                throw new Exception("Seacat is not initialized!");
+            }
+
+            lock (sharedHandlerLock) {
+                if (sharedHandler == null) {
+                    sharedHandler = new SeacatHttpClientHandler(Reactor, RequestPriority.DEFAULT);
+                    sharedHandler.HttpClient = new HttpClient(sharedHandler);
+                }
+                return sharedHandler;
+            }
+        }
+
+        /// <summary>
+        /// Raises or lowers priority of a request, 0 (highest) to 7 (lowest).
+        ///
+        /// Works both before the request is sent and while it is in flight; a request that waits for sending
+        /// overtakes (or lets through) requests of lower (higher) priority.
+        /// </summary>
+        public static void SetPriority(HttpRequestMessage request, int priority) {
+            RequestPriority.Set(request, priority);
+        }
+
+        /// <summary>
+        /// Opens the durable queue of fire-and-forget requests, journaled in the SeaCat storage directory.
+        ///
+        /// Requests left in the queue by the previous run are sent once the gateway connection is established.
+        /// </summary>
+        public static void OpenOfflineQueue() {
+            if (!initialized) {
+                throw new Exception("Seacat is not initialized!");
+            }
+            Reactor.OfflineQueue.Open();
+        }
+
+        /// <summary>
+        /// Stores a fire-and-forget request (telemetry, form submission) in the offline queue.
+        ///
+        /// The request survives restarts of the app and is sent in priority order once the gateway connection is established.
+        /// Returns false if the queue is not open or full.
+        /// </summary>
+        public static Task<bool> EnqueueOfflineAsync(HttpRequestMessage request) {
+            if (!initialized) {
+                throw new Exception("Seacat is not initialized!");
+            }
+            return Reactor.OfflineQueue.EnqueueAsync(request);
+        }
+
+        /// <summary>
+        /// Returns histograms of request timings (queue, gateway, transfer and total time) aggregated over completed requests.
+        ///
+        /// Timings of a single request are available in its properties under RequestTimings.PROPERTY.
+        /// </summary>
+        public static TimingStatistics GetTimingStatistics() {
+            if (!initialized) {
+                throw new Exception("Seacat is not initialized!");
+            }
+            return Reactor.TimingStatistics;
+        }
+
         /// <summary>
         /// Obtains the state string describing operational conditions of a SeaCat client.
         ///
@@ -205,6 +326,21 @@ namespace SeaCatCSharpClient {
             RC.CheckAndThrowIOException("seacatcc.yield(renew)", rc);
         }
 
+        /// <summary>
+        /// Starts generating the private key in the background right away, without waiting for the core to ask for it.
+        ///
+        /// Call it as early as possible after Initialize on the first launch; key generation takes seconds on low-end phones.
+        /// The CSR, if given, is submitted as soon as the key is ready and the core asks for it.
+        /// The returned task completes once the client is signed in to the gateway.
+        /// </summary>
+        public static Task PregenerateIdentity(CSR csr = null, IProgress<IdentityPhase> progress = null) {
+            if (!initialized) {
+                throw new Exception("Seacat is not initialized!");
+            }
+            Reactor.Identity.Pregenerate(csr, progress);
+            return Reactor.Identity.SignedIn;
+        }
+
         public static void SetCSRWorker(Task csrWorker) {
             SeaCatInternals.SetCSRWorker(csrWorker);
         }
@@ -35,6 +35,9 @@ namespace SeaCatCSharpClient {
             caps.Add($"plM\037{deviceInfo.SystemSku}");
             caps.Add($"plp\037{deviceInfo.SystemProductName}");
 
+            // Add protocol capabilities
+            caps.Add($"{SPDY.CHARACTERISTIC_HEADER_COMPRESSION}\037{SPDY.HEADER_COMPRESSION_VERSION}");
+
             // Add hardware capabilities
             //caps.Add(String.Format("%s\037%s", "hwb", deviceInfo.SystemFirmwareVersion));
             //caps.Add(String.Format("%s\037%s", "hwd", deviceInfo.SystemHardwareVersion));
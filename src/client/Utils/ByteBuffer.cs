@@ -21,6 +21,18 @@ namespace SeaCatCSharpClient.Utils {
 
         public byte[] Data { get { return _buffer; } }
 
+        /// <summary>
+        /// Id of the frame in the frame pool, -1 for buffers not created by the pool
+        /// </summary>
+        public int PoolId { get; internal set; } = -1;
+
+        /// <summary>
+        /// Generation of the frame, incremented each time the frame is borrowed from the pool
+        /// </summary>
+        public int Generation { get; internal set; } = 0;
+
+        internal bool Borrowed { get; set; } = false;
+
         public ByteBuffer(int capacity) : this(new byte[capacity]) { }
 
         public ByteBuffer(byte[] buffer) : this(buffer, 0) { }
@@ -137,10 +149,14 @@ namespace SeaCatCSharpClient.Utils {
         }
 
         public void PutBytes(byte[] values) {
-            for (int i = 0; i < values.Length; i++) {
-                AssertOffsetAndLength(_pos, sizeof(byte));
-                _buffer[_pos++] = values[i];
-            }
+            PutBytes(values, 0, values.Length);
+        }
+
+        public void PutBytes(byte[] values, int offset, int count) {
+            if (offset < 0 || count < 0 || offset > values.Length - count) throw new ArgumentOutOfRangeException();
+            AssertOffsetAndLength(_pos, count);
+            Buffer.BlockCopy(values, offset, _buffer, _pos, count);
+            _pos += count;
         }
 
 
@@ -221,6 +237,16 @@ namespace SeaCatCSharpClient.Utils {
             _pos += count;
         }
 
+        /// <summary>
+        /// Copies count bytes from the current position into destination starting at offset and advances the position
+        /// </summary>
+        public void Get(byte[] destination, int offset, int count) {
+            if (offset < 0 || count < 0 || offset > destination.Length - count) throw new ArgumentOutOfRangeException();
+            if (count > Remaining) throw new ArgumentOutOfRangeException();
+            Buffer.BlockCopy(_buffer, _pos, destination, offset, count);
+            _pos += count;
+        }
+
         public short GetShort(int offset) {
             // restore pos value when read
             int temp = _pos;
@@ -0,0 +1,86 @@
+﻿using System;
+using System.Text;
+using System.Threading;
+
+namespace SeaCatCSharpClient.Utils {
+
+    /// <summary>
+    /// Thread-safe histogram of durations in milliseconds with fixed, roughly logarithmic buckets
+    /// </summary>
+    public class Histogram {
+
+        /// <summary>
+        /// Upper bounds of the buckets in milliseconds, the last bucket is unbounded
+        /// </summary>
+        public static readonly double[] BOUNDS = { 1, 2, 5, 10, 20, 50, 100, 200, 500, 1000, 2000, 5000, 10000, 20000, 60000 };
+
+        private long[] counts = new long[BOUNDS.Length + 1];
+        private long count;
+
+        public string Name { get; private set; }
+
+        public Histogram(string name) {
+            this.Name = name;
+        }
+
+        /// <summary>
+        /// Number of recorded values
+        /// </summary>
+        public long Count => Interlocked.Read(ref count);
+
+        public void Record(double millis) {
+            int bucket = Array.BinarySearch(BOUNDS, millis);
+            if (bucket < 0) bucket = ~bucket;
+
+            Interlocked.Increment(ref counts[bucket]);
+            Interlocked.Increment(ref count);
+        }
+
+        /// <summary>
+        /// Returns a snapshot of the bucket counts, bucket i holds values up to BOUNDS[i]
+        /// </summary>
+        public long[] GetCounts() {
+            long[] snapshot = new long[counts.Length];
+            for (int i = 0; i < counts.Length; i++) {
+                snapshot[i] = Interlocked.Read(ref counts[i]);
+            }
+            return snapshot;
+        }
+
+        /// <summary>
+        /// Returns the upper bound of the bucket that contains given percentile (0-100)
+        /// </summary>
+        /// <returns>bound in milliseconds, infinity for the last bucket, NaN if nothing has been recorded</returns>
+        public double Percentile(double percentile) {
+            long[] snapshot = GetCounts();
+            long total = 0;
+            foreach (long c in snapshot) total += c;
+            if (total == 0) return double.NaN;
+
+            long rank = (long)Math.Ceiling(total * percentile / 100.0);
+            long seen = 0;
+            for (int i = 0; i < snapshot.Length; i++) {
+                seen += snapshot[i];
+                if (seen >= rank && seen > 0) return i < BOUNDS.Length ? BOUNDS[i] : double.PositiveInfinity;
+            }
+            return double.PositiveInfinity;
+        }
+
+        public void Clear() {
+            for (int i = 0; i < counts.Length; i++) {
+                Interlocked.Exchange(ref counts[i], 0);
+            }
+            Interlocked.Exchange(ref count, 0);
+        }
+
+        public override string ToString() {
+            long[] snapshot = GetCounts();
+            StringBuilder sb = new StringBuilder($"[Histogram {Name} count={Count}");
+            for (int i = 0; i < snapshot.Length; i++) {
+                if (snapshot[i] == 0) continue;
+                sb.Append(i < BOUNDS.Length ? $" <={BOUNDS[i]}ms:" : " >:").Append(snapshot[i]);
+            }
+            return sb.Append("]").ToString();
+        }
+    }
+}
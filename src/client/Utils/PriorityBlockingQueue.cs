@@ -65,27 +65,36 @@ namespace SeaCatCSharpClient.Utils {
             int idx = items.IndexOf(value);
             if (idx == -1) {
                 Logger.Error("PBQ", "Unknown value! Can't remove from queue");
+                return;
             }
 
-            items[idx] = items[queue.Count - 1];
-            items.RemoveAt(queue.Count - 1);
-            BubbleDown();
+            RemoveAt(idx);
         }
 
         public override void RemoveAt(int index) {
             var items = Items;
             items[index] = items[items.Count - 1];
             items.RemoveAt(items.Count - 1);
-            BubbleDown();
 
+            // the moved element may belong either above or below the removed one
+            if (index < items.Count) {
+                BubbleDown(index);
+                BubbleUp(index);
+            }
         }
 
         /// <summary>
         /// Bubble up the last element in the queue until it's in the correct spot.
         /// </summary>
         private void BubbleUp() {
+            BubbleUp(queue.Count - 1);
+        }
+
+        /// <summary>
+        /// Bubble up given element until it's in the correct spot.
+        /// </summary>
+        private void BubbleUp(int node) {
             var items = Items;
-            int node = queue.Count - 1;
             while (node > 0) {
                 int parent = (node - 1) >> 1;
                 if (priorityComparer.Compare(items[parent], items[node]) < 0) {
@@ -102,8 +111,14 @@ namespace SeaCatCSharpClient.Utils {
         /// Bubble down the first element until it's in the correct spot.
         /// </summary>
         private void BubbleDown() {
+            BubbleDown(0);
+        }
+
+        /// <summary>
+        /// Bubble down given element until it's in the correct spot.
+        /// </summary>
+        private void BubbleDown(int node) {
             var items = Items;
-            int node = 0;
             while (true) {
                 // Find smallest child
                 int child0 = (node << 1) + 1;
@@ -94,6 +94,55 @@ namespace SeaCatCSharpClient.Utils {
             }
         }
 
+        /// <summary>
+        /// Waits for the task without blocking a thread
+        /// </summary>
+        /// <returns>true if the task completed, false if the timeout elapsed first</returns>
+        public static async Task<bool> WaitAsync(Task task, TimeSpan timeout) {
+            if (task.IsCompleted) return true;
+
+            using (var delayCancel = new CancellationTokenSource()) {
+                var winner = await Task.WhenAny(task, Task.Delay(timeout, delayCancel.Token)).ConfigureAwait(false);
+                delayCancel.Cancel();
+                return winner == task;
+            }
+        }
+
+        /// <summary>
+        /// Completes the source with given result on a thread pool thread
+        /// Continuations of the awaiting code thus never run on the calling thread (e.g. on the reactor thread)
+        /// </summary>
+        public static void SetResultAsync<T>(TaskCompletionSource<T> source, T result) {
+            Task.Run(() => source.TrySetResult(result));
+        }
+
+        /// <summary>
+        /// Creates the result on a thread pool thread and completes the source with it
+        /// </summary>
+        public static void SetResultAsync<T>(TaskCompletionSource<T> source, Func<T> resultFactory) {
+            Task.Run(() => {
+                try {
+                    source.TrySetResult(resultFactory());
+                } catch (Exception e) {
+                    source.TrySetException(e);
+                }
+            });
+        }
+
+        /// <summary>
+        /// Faults the source with given exception on a thread pool thread
+        /// </summary>
+        public static void SetExceptionAsync<T>(TaskCompletionSource<T> source, Exception exception) {
+            Task.Run(() => source.TrySetException(exception));
+        }
+
+        /// <summary>
+        /// Cancels the source on a thread pool thread, so that continuations don't run on the caller's thread
+        /// </summary>
+        public static void SetCanceledAsync<T>(TaskCompletionSource<T> source) {
+            Task.Run(() => source.TrySetCanceled());
+        }
+
         private static TaskMetadata GetMetadata(int? id) {
             if (_alltasks.ContainsKey(id)) {
                 return _alltasks[id];